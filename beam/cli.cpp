@@ -181,6 +181,7 @@ int main_impl(int argc, char* argv[])
 					node.m_Cfg.m_MiningThreads = vm[cli::MINING_THREADS].as<uint32_t>();
 #endif
 					node.m_Cfg.m_VerificationThreads = vm[cli::VERIFICATION_THREADS].as<int>();
+					node.m_Cfg.m_VerificationBatch.m_MaxProofs = vm[cli::VERIFICATION_BATCH].as<uint32_t>();
 					if (node.m_Cfg.m_MiningThreads > 0 || stratumServer)
 					{
 						ECC::NoLeak<ECC::uintBig> seed;
@@ -114,9 +114,9 @@ namespace beam
 
 	/////////////
 	// Output
-	bool Output::IsValid(ECC::Point::Native& comm) const
+	bool Output::IsValid(ECC::Point::Native& comm, ECC::PointCache* pCache /* = NULL */) const
 	{
-		if (!comm.Import(m_Commitment))
+		if (!(pCache ? pCache->Import(comm, m_Commitment, true) : comm.Import(m_Commitment)))
 			return false;
 
 		ECC::Oracle oracle;
@@ -984,13 +984,14 @@ namespace beam
 		m_Offset = offs;
 	}
 
-	bool Block::BodyBase::IsValid(const HeightRange& hr, bool bSubsidyOpen, TxBase::IReader&& r) const
+	bool Block::BodyBase::IsValid(const HeightRange& hr, bool bSubsidyOpen, TxBase::IReader&& r, ECC::PointCache* pCache /* = NULL */) const
 	{
 		assert((hr.m_Min >= Rules::HeightGenesis) && !hr.IsEmpty());
 
 		TxBase::Context ctx;
 		ctx.m_Height = hr;
 		ctx.m_bBlockMode = true;
+		ctx.m_pPointCache = pCache;
 
 		return
 			ctx.ValidateAndSummarize(*this, std::move(r)) &&
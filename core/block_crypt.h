@@ -16,6 +16,7 @@
 #include "ecc_native.h"
 #include "merkle.h"
 #include "difficulty.h"
+#include <atomic>
 
 namespace beam
 {
@@ -186,7 +187,7 @@ namespace beam
 
 		bool Recover(Key::IPKdf&, Key::IDV&) const;
 
-		bool IsValid(ECC::Point::Native& comm) const;
+		bool IsValid(ECC::Point::Native& comm, ECC::PointCache* pCache = NULL) const; // the commitment is imported via the cache, if specified
 		Height get_MinMaturity(Height h) const; // regardless to the explicitly-overridden
 
 		void operator = (const Output&);
@@ -511,7 +512,7 @@ namespace beam
 			// Not tested by this function (but should be tested by nodes!)
 			//		Existence of all the input UTXOs
 			//		Existence of the coinbase non-confidential output UTXO, with the sum amount equal to the new coin emission.
-			bool IsValid(const HeightRange&, bool bSubsidyOpen, TxBase::IReader&&) const;
+			bool IsValid(const HeightRange&, bool bSubsidyOpen, TxBase::IReader&&, ECC::PointCache* pCache = NULL) const;
 
 			struct IMacroReader
 				:public IReader
@@ -583,7 +584,7 @@ namespace beam
 
 	class TxBase::Context
 	{
-		bool ShouldVerify(uint32_t& iV) const;
+		bool ShouldVerify(uint32_t iElement, uint32_t& iChunk);
 		bool ShouldAbort() const;
 
 		bool HandleElementHeight(const HeightRange&);
@@ -619,10 +620,25 @@ namespace beam
 
 		bool m_bVerifyOrder; // check the correct order, as well as elimination of spent outputs. On by default. Turned Off only for specific internal validations (such as treasury).
 
-		// for multi-tasking, parallel verification
-		uint32_t m_nVerifiers;
-		uint32_t m_iVerifier;
+		// for multi-tasking, parallel verification.
+		// Elements (inputs, outputs, kernels, offset) are split into chunks of consecutive elements, which the verifiers grab dynamically,
+		// so that the faster verifiers take more work (outputs are much heavier than inputs). The grabbed chunks are ascending, hence each verifier
+		// only moves forward, and sequential readers are fine.
+		struct Chunks
+		{
+			static const uint32_t s_Size = 16; // elements per chunk
+
+			std::atomic<uint32_t> m_iNext;
+
+			Chunks() :m_iNext(0) {}
+			uint32_t Grab() { return m_iNext++; }
+		};
+
+		Chunks* m_pChunks; // shared by all the verifiers of the same task. If NULL - all the elements are verified
 		volatile bool* m_pAbort;
+		uint32_t m_nVerified; // elements verified by this context (not merged)
+
+		ECC::PointCache* m_pPointCache; // optional. Populated by the outputs, consulted by the inputs
 
 		Context() { Reset(); }
 		void Reset();
@@ -689,12 +705,13 @@ namespace beam
 
 	public:
 
-		RW() :m_bAutoDelete(false) {}
+		RW() :m_bAutoDelete(false) ,m_bMapped(true) {}
 		~RW();
 
 		// do not modify between Open() and Close()
 		bool m_bRead;
 		bool m_bAutoDelete;
+		bool m_bMapped; // in read mode the files are memory-mapped (if possible), clones share the mappings
 		std::string m_sPath;
 		Merkle::Hash m_hvContentTag; // needed to make sure all the files indeed belong to the same data set
 
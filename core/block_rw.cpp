@@ -67,7 +67,12 @@ namespace beam
 	{
 		std::string s;
 		GetPath(s, iData);
-		if (!m_pS[iData].Open(s.c_str(), m_bRead))
+
+		bool bOpen =
+			(m_bRead && m_bMapped && m_pS[iData].OpenMapped(s.c_str())) ||
+			m_pS[iData].Open(s.c_str(), m_bRead);
+
+		if (!bOpen)
 			return false;
 
 		PostOpen(iData);
@@ -165,7 +170,28 @@ namespace beam
 		pOut.reset(pRet);
 
 		pRet->m_sPath = m_sPath;
-		pRet->Open(m_bRead);
+		pRet->m_bMapped = m_bMapped;
+
+		if (!m_bRead || !m_bMapped)
+		{
+			pRet->Open(m_bRead);
+			return;
+		}
+
+		// share the mappings, no need to reopen the files
+		pRet->m_bRead = true;
+		ZeroObject(pRet->m_pMaturity);
+
+		for (int i = 0; i < Type::count; i++)
+		{
+			if (m_pS[i].IsMapped())
+			{
+				pRet->m_pS[i].OpenMapped(m_pS[i]);
+				pRet->PostOpen(i);
+			}
+			else
+				pRet->OpenInternal(i); // absent, or mapping failed
+		}
 	}
 
 	void Block::BodyBase::RW::NextUtxoIn()
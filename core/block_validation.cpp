@@ -27,20 +27,32 @@ namespace beam
 		m_Height.Reset();
 		m_bBlockMode = false;
 		m_bVerifyOrder = true;
-		m_nVerifiers = 1;
-		m_iVerifier = 0;
+		m_pChunks = NULL;
 		m_pAbort = NULL;
+		m_nVerified = 0;
+		m_pPointCache = NULL;
 	}
 
-	bool TxBase::Context::ShouldVerify(uint32_t& iV) const
+	bool TxBase::Context::ShouldVerify(uint32_t iElement, uint32_t& iChunk)
 	{
-		if (iV)
+		if (!m_pChunks)
 		{
-			iV--;
-			return false;
+			m_nVerified++;
+			return true;
 		}
 
-		iV = m_nVerifiers - 1;
+		uint32_t iElementChunk = iElement / Chunks::s_Size;
+		if (iElementChunk > iChunk)
+		{
+			// the elements are visited consequently, hence we've just left our chunk. Grab the next one, it's never behind.
+			iChunk = m_pChunks->Grab();
+			assert(iChunk >= iElementChunk);
+		}
+
+		if (iElementChunk != iChunk)
+			return false;
+
+		m_nVerified++;
 		return true;
 	}
 
@@ -82,20 +94,20 @@ namespace beam
 
 		m_Sigma = -m_Sigma;
 
-		assert(m_nVerifiers);
-		uint32_t iV = m_iVerifier;
+		uint32_t iElement = 0;
+		uint32_t iChunk = m_pChunks ? m_pChunks->Grab() : 0;
 
 		// Inputs
 		r.Reset();
 
 		ECC::Point::Native pt;
 
-		for (const Input* pPrev = NULL; r.m_pUtxoIn; pPrev = r.m_pUtxoIn, r.NextUtxoIn())
+		for (const Input* pPrev = NULL; r.m_pUtxoIn; pPrev = r.m_pUtxoIn, r.NextUtxoIn(), iElement++)
 		{
 			if (ShouldAbort())
 				return false;
 
-			if (ShouldVerify(iV))
+			if (ShouldVerify(iElement, iChunk))
 			{
 				if (m_bVerifyOrder)
 				{
@@ -114,7 +126,8 @@ namespace beam
 					}
 				}
 
-				if (!pt.Import(r.m_pUtxoIn->m_Commitment))
+				const ECC::Point& comm = r.m_pUtxoIn->m_Commitment;
+				if (!(m_pPointCache ? m_pPointCache->Import(pt, comm, false) : pt.Import(comm)))
 					return false;
 
 				m_Sigma += pt;
@@ -126,17 +139,17 @@ namespace beam
 		// Outputs
 		r.Reset();
 
-		for (const Output* pPrev = NULL; r.m_pUtxoOut; pPrev = r.m_pUtxoOut, r.NextUtxoOut())
+		for (const Output* pPrev = NULL; r.m_pUtxoOut; pPrev = r.m_pUtxoOut, r.NextUtxoOut(), iElement++)
 		{
 			if (ShouldAbort())
 				return false;
 
-			if (ShouldVerify(iV))
+			if (ShouldVerify(iElement, iChunk))
 			{
 				if (m_bVerifyOrder && pPrev && (*pPrev > *r.m_pUtxoOut))
 					return false;
 
-				if (!r.m_pUtxoOut->IsValid(pt))
+				if (!r.m_pUtxoOut->IsValid(pt, m_pPointCache))
 					return false;
 
 				m_Sigma += pt;
@@ -152,12 +165,12 @@ namespace beam
 			}
 		}
 
-		for (const TxKernel* pPrev = NULL; r.m_pKernel; pPrev = r.m_pKernel, r.NextKernel())
+		for (const TxKernel* pPrev = NULL; r.m_pKernel; pPrev = r.m_pKernel, r.NextKernel(), iElement++)
 		{
 			if (ShouldAbort())
 				return false;
 
-			if (ShouldVerify(iV))
+			if (ShouldVerify(iElement, iChunk))
 			{
 				if (m_bVerifyOrder && pPrev && (*pPrev > *r.m_pKernel))
 					return false;
@@ -170,7 +183,7 @@ namespace beam
 			}
 		}
 
-		if (ShouldVerify(iV))
+		if (ShouldVerify(iElement, iChunk))
 			m_Sigma += ECC::Context::get().G * txb.m_Offset;
 
 		assert(!m_Height.IsEmpty());
@@ -14,6 +14,7 @@
 
 #include "common.h"
 #include "ecc_native.h"
+#include <thread>
 
 #define ENABLE_MODULE_GENERATOR
 #define ENABLE_MODULE_RANGEPROOF
@@ -436,6 +437,95 @@ namespace ECC {
 		return memis0(&v, sizeof(v));
 	}
 
+	/////////////////////
+	// PointCache
+	void PointCache::Resize(size_t nBytes)
+	{
+		size_t nSlots = 0;
+		if (nBytes >= sizeof(Slot))
+			for (nSlots = 1; (nSlots << 1) * sizeof(Slot) <= nBytes; )
+				nSlots <<= 1;
+
+		std::vector<Slot> v(nSlots);
+		for (size_t i = 0; i < v.size(); i++)
+			v[i].m_bValid = false;
+
+		m_vSlots.swap(v);
+	}
+
+	size_t PointCache::get_Slot(const Point& v) const
+	{
+		// x coordinate is uniformly distributed
+		uint64_t n;
+		memcpy(&n, v.m_X.m_pData, sizeof(n));
+		return static_cast<size_t>(n ^ v.m_Y) & (m_vSlots.size() - 1);
+	}
+
+	bool PointCache::Import(Point::Native& res, const Point& v, bool bInsert)
+	{
+		if (m_vSlots.empty())
+			return res.Import(v);
+
+		m_Lookups.fetch_add(1, std::memory_order_relaxed);
+
+		size_t iSlot = get_Slot(v);
+		Slot& s = m_vSlots[iSlot];
+		std::mutex& mx = m_pMutex[iSlot & (s_Locks - 1)];
+
+		{
+			std::unique_lock<std::mutex> scope(mx);
+
+			if (s.m_bValid && (s.m_Key == v))
+			{
+				secp256k1_ge ge;
+				secp256k1_ge_from_storage(&ge, &s.m_Pt);
+
+				scope.unlock();
+
+				secp256k1_gej_set_ge(&res.get_Raw(), &ge);
+				m_Hits.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		if (!res.ImportNnz(v))
+		{
+			res = Zero;
+			return memis0(&v, sizeof(v));
+		}
+
+		if (bInsert)
+		{
+			// freshly imported point is affine (z == 1)
+			const secp256k1_gej& gej = res.get_Raw();
+
+			secp256k1_ge ge;
+			ge.x = gej.x;
+			ge.y = gej.y;
+			ge.infinity = 0;
+
+			secp256k1_ge_storage ges;
+			secp256k1_ge_to_storage(&ges, &ge);
+
+			std::unique_lock<std::mutex> scope(mx);
+
+			s.m_Key = v;
+			s.m_Pt = ges;
+			s.m_bValid = true;
+
+			m_Inserts.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		return true;
+	}
+
+	void PointCache::get_Stats(Stats& s) const
+	{
+		s.m_Lookups = m_Lookups.load(std::memory_order_relaxed);
+		s.m_Hits = m_Hits.load(std::memory_order_relaxed);
+		s.m_Inserts = m_Inserts.load(std::memory_order_relaxed);
+	}
+
 	bool Point::Native::Export(Point& v) const
 	{
 		if (*this == Zero)
@@ -872,6 +962,8 @@ namespace ECC {
 		unsigned int pTblCasual[nBits];
 		unsigned int pTblPrepared[nBits];
 
+		bool bBuckets = (Mode::Fast == g_Mode) && (static_cast<uint32_t>(m_Casual) >= s_BucketsMin);
+
 		if (Mode::Fast == g_Mode)
 		{
 			ZeroObject(pTblCasual);
@@ -880,11 +972,12 @@ namespace ECC {
 			for (int iEntry = 0; iEntry < m_Prepared; iEntry++)
 				m_pAuxPrepared[iEntry].Schedule(m_pKPrep[iEntry], nBits, Prepared::Fast::nMaxOdd, pTblPrepared, iEntry + 1);
 
-			for (int iEntry = 0; iEntry < m_Casual; iEntry++)
-			{
-				Casual& x = m_pCasual[iEntry];
-				x.m_Aux.Schedule(x.m_K, nBits, Casual::Fast::nMaxOdd, pTblCasual, iEntry + 1);
-			}
+			if (!bBuckets)
+				for (int iEntry = 0; iEntry < m_Casual; iEntry++)
+				{
+					Casual& x = m_pCasual[iEntry];
+					x.m_Aux.Schedule(x.m_K, nBits, Casual::Fast::nMaxOdd, pTblCasual, iEntry + 1);
+				}
 
 		}
 
@@ -996,6 +1089,168 @@ namespace ECC {
 				Generator::ToPt(res, ge.V, Context::get().m_Casual.m_Compensation, false);
 
 		}
+
+		if (bBuckets)
+		{
+			Point::Native resCasual;
+			CalculateCasualBuckets(resCasual);
+			res += resCasual;
+		}
+	}
+
+	uint32_t MultiMac::s_BucketsMin = 128;
+
+	void MultiMac::get_Part(MultiMac& mm, uint32_t iPart, uint32_t nParts) const
+	{
+		uint32_t i0 = static_cast<uint32_t>(static_cast<uint64_t>(m_Casual) * iPart / nParts);
+		uint32_t i1 = static_cast<uint32_t>(static_cast<uint64_t>(m_Casual) * (iPart + 1) / nParts);
+
+		mm.m_pCasual = m_pCasual + i0;
+		mm.m_Casual = i1 - i0;
+
+		i0 = static_cast<uint32_t>(static_cast<uint64_t>(m_Prepared) * iPart / nParts);
+		i1 = static_cast<uint32_t>(static_cast<uint64_t>(m_Prepared) * (iPart + 1) / nParts);
+
+		mm.m_ppPrepared = m_ppPrepared + i0;
+		mm.m_pKPrep = m_pKPrep + i0;
+		mm.m_pAuxPrepared = m_pAuxPrepared + i0;
+		mm.m_Prepared = i1 - i0;
+	}
+
+	void MultiMac::CalculateParallel(Point::Native& res, uint32_t nThreads) const
+	{
+		if (nThreads <= 1)
+		{
+			Calculate(res);
+			return;
+		}
+
+		// the parts are disjoint, including the casual points state and the prepared aux
+		std::vector<Point::Native> vRes(nThreads - 1);
+		std::vector<std::thread> vThreads(nThreads - 1);
+
+		Mode::Enum eMode = g_Mode; // thread-local
+
+		for (uint32_t i = 0; i < vThreads.size(); i++)
+		{
+			Point::Native& resPart = vRes[i];
+			vThreads[i] = std::thread([this, &resPart, eMode, i, nThreads]() {
+
+				Mode::Scope scope(eMode);
+
+				MultiMac mm;
+				get_Part(mm, i + 1, nThreads);
+				mm.Calculate(resPart);
+			});
+		}
+
+		MultiMac mm;
+		get_Part(mm, 0, nThreads);
+		mm.Calculate(res);
+
+		for (uint32_t i = 0; i < vThreads.size(); i++)
+		{
+			vThreads[i].join();
+			res += vRes[i];
+		}
+	}
+
+	unsigned int GetBits(const Scalar::Native& k, unsigned int iBit, unsigned int nBitsWnd)
+	{
+		const Scalar::Native::uint* p = k.get().d;
+		const unsigned int nWordBits = sizeof(*p) << 3;
+		const unsigned int nWords = sizeof(k.get().d) / sizeof(*p);
+
+		unsigned int iWord = iBit / nWordBits;
+		unsigned int iBitInWord = iBit & (nWordBits - 1);
+
+		unsigned int n = static_cast<unsigned int>(p[iWord] >> iBitInWord);
+		if ((iBitInWord + nBitsWnd > nWordBits) && (iWord + 1 < nWords))
+			n |= static_cast<unsigned int>(p[iWord + 1] << (nWordBits - iBitInWord));
+
+		return n & ((1U << nBitsWnd) - 1);
+	}
+
+	void MultiMac::CalculateCasualBuckets(Point::Native& res) const
+	{
+		// Variable-time, fast mode only.
+		// For each window the points are added to the buckets according to their digit, then the buckets are summed
+		// via the running sum: S = sum(i * B[i]). Window width is chosen to minimize the number of additions.
+		uint32_t n = static_cast<uint32_t>(m_Casual);
+
+		unsigned int nWnd = 1;
+		uint64_t nCostMin = uint64_t(-1);
+		for (unsigned int w = 1; w <= 16; w++)
+		{
+			uint64_t nCost = uint64_t((nBits + w - 1) / w) * (n + (uint64_t(2) << w));
+			if (nCost < nCostMin)
+			{
+				nCostMin = nCost;
+				nWnd = w;
+			}
+		}
+
+		// to affine, with a single inversion
+		std::vector<secp256k1_ge> vPt(n);
+		{
+			std::vector<secp256k1_fe> vZ, vZi;
+			vZ.reserve(n);
+
+			for (uint32_t i = 0; i < n; i++)
+			{
+				const secp256k1_gej& gej = m_pCasual[i].m_pPt[1].get_Raw();
+				if (!gej.infinity)
+					vZ.push_back(gej.z);
+			}
+
+			vZi.resize(vZ.size());
+			if (!vZ.empty())
+				secp256k1_fe_inv_all_var(&vZi.front(), &vZ.front(), vZ.size());
+
+			for (uint32_t i = 0, iZ = 0; i < n; i++)
+			{
+				const secp256k1_gej& gej = m_pCasual[i].m_pPt[1].get_Raw();
+				vPt[i].infinity = gej.infinity;
+				if (!gej.infinity)
+					secp256k1_ge_set_gej_zinv(&vPt[i], &gej, &vZi[iZ++]);
+			}
+		}
+
+		std::vector<secp256k1_gej> vBuckets(size_t(1) << nWnd);
+
+		secp256k1_gej& r = res.get_Raw();
+		secp256k1_gej_set_infinity(&r);
+
+		for (unsigned int iWnd = (nBits + nWnd - 1) / nWnd; iWnd--; )
+		{
+			for (unsigned int i = 0; i < nWnd; i++)
+				secp256k1_gej_double_var(&r, &r, NULL);
+
+			for (size_t i = 1; i < vBuckets.size(); i++)
+				secp256k1_gej_set_infinity(&vBuckets[i]);
+
+			unsigned int iBit = iWnd * nWnd;
+			unsigned int nBitsWnd = std::min(nWnd, nBits - iBit);
+
+			for (uint32_t i = 0; i < n; i++)
+			{
+				unsigned int nVal = GetBits(m_pCasual[i].m_K, iBit, nBitsWnd);
+				if (nVal)
+					secp256k1_gej_add_ge_var(&vBuckets[nVal], &vBuckets[nVal], &vPt[i], NULL);
+			}
+
+			secp256k1_gej sum, acc;
+			secp256k1_gej_set_infinity(&sum);
+			secp256k1_gej_set_infinity(&acc);
+
+			for (size_t i = vBuckets.size(); --i; )
+			{
+				secp256k1_gej_add_var(&sum, &sum, &vBuckets[i], NULL);
+				secp256k1_gej_add_var(&acc, &acc, &sum, NULL);
+			}
+
+			secp256k1_gej_add_var(&r, &r, &acc, NULL);
+		}
 	}
 
 	/////////////////////
@@ -1443,7 +1698,37 @@ namespace ECC {
 		if (!pubNonce.Import(m_NoncePub))
 			return false;
 
-		return IsValidPartial(msg, pubNonce, pk);
+		InnerProduct::BatchContext* pBc = InnerProduct::BatchContext::s_pInstance;
+		if (!pBc || !pBc->m_bEnableBatch)
+			return IsValidPartial(msg, pubNonce, pk);
+
+		// G * m_k + pk * e + pubNonce == 0, added to the batch with a pseudo-random weight derived from all the equation terms
+		InnerProduct::BatchContext& bc = *pBc;
+
+		Mode::Scope scope(Mode::Fast);
+
+		Oracle()
+			<< m_NoncePub
+			<< m_k
+			<< msg
+			<< pk
+			>> bc.m_Multiplier;
+
+		if (!bc.EquationBegin(2))
+			return false;
+
+		Scalar::Native e;
+		get_Challenge(e, m_NoncePub, msg);
+
+		bc.AddCasual(pk, e);
+
+		e = 1U;
+		bc.AddCasual(pubNonce, e);
+
+		e = m_k;
+		bc.AddPrepared(InnerProduct::BatchContext::s_Idx_G, e);
+
+		return bc.EquationEnd();
 	}
 
 	int Signature::cmp(const Signature& x) const
@@ -158,7 +158,7 @@ namespace ECC
 		Point m_NoncePub;
 		Scalar m_k;
 
-		bool IsValid(const Hash::Value& msg, const Point::Native& pk) const;
+		bool IsValid(const Hash::Value& msg, const Point::Native& pk) const; // deferred till Flush() if InnerProduct::BatchContext is active
 		bool IsValidPartial(const Hash::Value& msg, const Point::Native& pubNonce, const Point::Native& pk) const;
 
 		// simple signature
@@ -302,6 +302,7 @@ namespace ECC
 
 		struct BatchContext;
 		template <uint32_t nBatchSize> struct BatchContextEx;
+		struct BatchContextHeap;
 
 		void Create(Oracle&, const Scalar::Native& dotAB, const Scalar::Native* pA, const Scalar::Native* pB, const Modifier& = Modifier());
 
@@ -25,6 +25,8 @@ namespace ECC {
 	InnerProduct::BatchContext::BatchContext(uint32_t nCasualTotal)
 		:m_CasualTotal(nCasualTotal)
 		,m_bEnableBatch(false)
+		,m_nThreads(1)
+		,m_pJournal(NULL)
 	{
 		m_ppPrepared = m_Bufs.m_ppPrepared;
 		m_pKPrep = m_Bufs.m_pKPrep;
@@ -48,12 +50,33 @@ namespace ECC {
 		m_Casual = 0;
 		ZeroObject(m_Bufs.m_pKPrep);
 		m_bDirty = false;
+
+		if (m_pJournal)
+		{
+			m_pJournal->m_vEqs.clear();
+			m_pJournal->m_vPrepared.clear();
+			m_pJournal->m_bOpen = false;
+		}
+	}
+
+	void InnerProduct::BatchContext::Journal::Reset()
+	{
+		m_iEquation = 0;
+		m_vInvalid.clear();
+		m_vEqs.clear();
+		m_vPrepared.clear();
+		m_bOpen = false;
 	}
 
+	uint32_t InnerProduct::BatchContext::s_CasualPerThreadMin = 512;
+
 	void InnerProduct::BatchContext::Calculate(Point::Native& res)
 	{
 		Mode::Scope scope(Mode::Fast);
-		MultiMac::Calculate(res);
+
+		uint32_t nThreads = std::min(m_nThreads, static_cast<uint32_t>(m_Casual) / s_CasualPerThreadMin);
+
+		MultiMac::CalculateParallel(res, nThreads);
 	}
 
 	bool InnerProduct::BatchContext::AddCasual(const Point& p, const Scalar::Native& k)
@@ -87,6 +110,12 @@ namespace ECC {
 
 	bool InnerProduct::BatchContext::Flush()
 	{
+		if (m_pJournal)
+		{
+			FlushJournaled();
+			return m_pJournal->m_vInvalid.empty();
+		}
+
 		if (!m_bDirty)
 			return true;
 
@@ -101,20 +130,30 @@ namespace ECC {
 
 	bool InnerProduct::BatchContext::EquationBegin(uint32_t nCasualNeeded)
 	{
-		if (nCasualNeeded > m_CasualTotal)
+		if ((nCasualNeeded > m_CasualTotal) && !Grow(nCasualNeeded))
 		{
 			assert(false);
 			return false; // won't fit!
 		}
 
+		if (m_pJournal)
+			JournalRollback(); // the previous equation wasn't completed
+
 		nCasualNeeded += m_Casual;
-		if (nCasualNeeded > m_CasualTotal)
+		if ((nCasualNeeded > m_CasualTotal) && !Grow(nCasualNeeded))
 		{
-			if (!Flush())
-				return false;
+			if (m_pJournal)
+				FlushJournaled(); // failures are recorded, don't fail the current equation
+			else
+				if (!Flush())
+					return false;
 		}
 
 		m_bDirty = true;
+
+		if (m_pJournal)
+			JournalBegin();
+
 		return true;
 	}
 
@@ -122,12 +161,193 @@ namespace ECC {
 	{
 		assert(m_bDirty);
 
+		if (m_pJournal)
+			JournalEnd();
+
 		if (!m_bEnableBatch)
 			return Flush();
 
 		return true;
 	}
 
+	InnerProduct::BatchContextHeap::BatchContextHeap(uint32_t nProofsInitial, uint32_t nProofsMax)
+		:BatchContext(0)
+		,m_CasualMin(std::min(std::max(nProofsInitial, 1U), std::max(nProofsMax, 1U)) * s_CasualCountPerProof)
+		,m_CasualMax(std::max(nProofsMax, 1U) * s_CasualCountPerProof)
+		,m_CasualPeak(0)
+		,m_nTrimCalls(0)
+	{
+		m_pCasual = NULL;
+		Realloc(m_CasualMin);
+	}
+
+	bool InnerProduct::BatchContextHeap::Grow(uint32_t nCasualNeeded)
+	{
+		m_CasualPeak = std::max(m_CasualPeak, nCasualNeeded);
+
+		if (nCasualNeeded > m_CasualMax)
+			return false;
+
+		Realloc(std::min(std::max(m_CasualTotal * 2, nCasualNeeded), m_CasualMax));
+		return true;
+	}
+
+	void InnerProduct::BatchContextHeap::Trim()
+	{
+		m_CasualPeak = std::max(m_CasualPeak, static_cast<uint32_t>(m_Casual));
+
+		if (++m_nTrimCalls < s_TrimPeriod)
+			return;
+
+		uint32_t nCasualTotal = std::max(m_CasualPeak * 2, m_CasualMin);
+		if (m_CasualPeak * 4 < m_CasualTotal)
+			Realloc(nCasualTotal);
+
+		m_CasualPeak = 0;
+		m_nTrimCalls = 0;
+	}
+
+	void InnerProduct::BatchContextHeap::Realloc(uint32_t nCasualTotal)
+	{
+		assert(nCasualTotal >= static_cast<uint32_t>(m_Casual));
+
+		std::unique_ptr<MultiMac::Casual[]> pBuf(new MultiMac::Casual[nCasualTotal]);
+		std::copy(m_pCasual, m_pCasual + m_Casual, pBuf.get());
+
+		m_pBuf.swap(pBuf);
+		m_pCasual = m_pBuf.get();
+		m_CasualTotal = nCasualTotal;
+	}
+
+	void InnerProduct::BatchContext::JournalBegin()
+	{
+		Journal& j = *m_pJournal;
+		assert(!j.m_bOpen);
+
+		j.m_vEqs.emplace_back();
+		Journal::Equation& eq = j.m_vEqs.back();
+		eq.m_iIdx = j.m_iEquation++;
+		eq.m_iCasual = m_Casual;
+
+		// snapshot of the prepared scalars, converted to the delta when the equation ends
+		j.m_vPrepared.insert(j.m_vPrepared.end(), m_Bufs.m_pKPrep, m_Bufs.m_pKPrep + s_CountPrepared);
+		j.m_bOpen = true;
+	}
+
+	void InnerProduct::BatchContext::JournalEnd()
+	{
+		Journal& j = *m_pJournal;
+		if (!j.m_bOpen)
+			return;
+
+		Scalar::Native* pK = &j.m_vPrepared.front() + j.m_vPrepared.size() - s_CountPrepared;
+		for (uint32_t i = 0; i < s_CountPrepared; i++)
+		{
+			pK[i] = -pK[i];
+			pK[i] += m_Bufs.m_pKPrep[i];
+		}
+
+		j.m_bOpen = false;
+	}
+
+	void InnerProduct::BatchContext::JournalRollback()
+	{
+		Journal& j = *m_pJournal;
+		if (!j.m_bOpen)
+			return;
+
+		const Journal::Equation& eq = j.m_vEqs.back();
+		m_Casual = eq.m_iCasual;
+		j.m_vInvalid.push_back(eq.m_iIdx);
+
+		const Scalar::Native* pK = &j.m_vPrepared.front() + j.m_vPrepared.size() - s_CountPrepared;
+		for (uint32_t i = 0; i < s_CountPrepared; i++)
+			m_Bufs.m_pKPrep[i] = pK[i];
+
+		j.m_vEqs.pop_back();
+		j.m_vPrepared.resize(j.m_vPrepared.size() - s_CountPrepared);
+		j.m_bOpen = false;
+
+		m_bDirty = !j.m_vEqs.empty();
+	}
+
+	void InnerProduct::BatchContext::FlushJournaled()
+	{
+		JournalRollback();
+
+		if (m_bDirty)
+		{
+			Point::Native pt;
+			Calculate(pt);
+			if (!(pt == Zero))
+			{
+				Journal& j = *m_pJournal;
+				Bisect(0, static_cast<uint32_t>(j.m_vEqs.size()));
+				std::sort(j.m_vInvalid.begin(), j.m_vInvalid.end());
+			}
+		}
+
+		Reset();
+	}
+
+	bool InnerProduct::BatchContext::IsZeroJournaled(uint32_t iEq0, uint32_t iEq1)
+	{
+		// evaluate the sub-range of the batch. The casual points are contiguous, the prepared scalars are summed from the recorded deltas
+		const Journal& j = *m_pJournal;
+		assert((iEq0 < iEq1) && (iEq1 <= j.m_vEqs.size()));
+
+		uint32_t iCasual0 = j.m_vEqs[iEq0].m_iCasual;
+		uint32_t iCasual1 = (iEq1 < j.m_vEqs.size()) ? j.m_vEqs[iEq1].m_iCasual : m_Casual;
+
+		Scalar::Native pKPrep[s_CountPrepared];
+		FastAux pAuxPrepared[s_CountPrepared];
+
+		for (uint32_t i = 0; i < s_CountPrepared; i++)
+			pKPrep[i] = Zero;
+
+		for (uint32_t iEq = iEq0; iEq < iEq1; iEq++)
+		{
+			const Scalar::Native* pK = &j.m_vPrepared.front() + iEq * s_CountPrepared;
+			for (uint32_t i = 0; i < s_CountPrepared; i++)
+				pKPrep[i] += pK[i];
+		}
+
+		MultiMac mm;
+		mm.m_pCasual = m_pCasual + iCasual0;
+		mm.m_Casual = iCasual1 - iCasual0;
+		mm.m_ppPrepared = m_ppPrepared;
+		mm.m_pKPrep = pKPrep;
+		mm.m_pAuxPrepared = pAuxPrepared;
+		mm.m_Prepared = s_CountPrepared;
+
+		Mode::Scope scope(Mode::Fast);
+
+		Point::Native pt;
+		mm.Calculate(pt);
+		return pt == Zero;
+	}
+
+	void InnerProduct::BatchContext::Bisect(uint32_t iEq0, uint32_t iEq1)
+	{
+		// the range is known to be invalid
+		if (iEq1 - iEq0 == 1)
+		{
+			m_pJournal->m_vInvalid.push_back(m_pJournal->m_vEqs[iEq0].m_iIdx);
+			return;
+		}
+
+		uint32_t iMid = (iEq0 + iEq1) >> 1;
+
+		if (IsZeroJournaled(iEq0, iMid))
+			Bisect(iMid, iEq1); // no need to evaluate the 2nd half
+		else
+		{
+			Bisect(iEq0, iMid);
+			if (!IsZeroJournaled(iMid, iEq1))
+				Bisect(iMid, iEq1);
+		}
+	}
+
 
 	struct InnerProduct::Calculator
 	{
@@ -475,7 +695,7 @@ namespace ECC {
 		Challenges cs_;
 		cs_.Init(oracle, dotAB, *this);
 
-		if (!bc.EquationBegin(1))
+		if (!bc.EquationBegin(1 + nCycles * 2)) // commAB, L[], R[]
 			return false;
 
 		bc.AddCasual(commAB, cs_.m_Mul2);
@@ -1075,7 +1295,7 @@ namespace ECC {
 		if (bc.m_bEnableBatch)
 			Oracle() << bc.m_Multiplier >> bc.m_Multiplier;
 
-		if (!bc.EquationBegin(2))
+		if (!bc.EquationBegin(2 + InnerProduct::nCycles * 2)) // A, S, L[], R[]
 			return false;
 
 		InnerProduct::Challenges cs_;
@@ -15,6 +15,8 @@
 #pragma once
 #include "ecc.h"
 #include <assert.h>
+#include <atomic>
+#include <mutex>
 
 #define USE_BASIC_CONFIG
 
@@ -244,6 +246,18 @@ namespace ECC
 
 		void Reset();
 		void Calculate(Point::Native&) const;
+
+		// In fast mode, if there are at least this many casual points - they're evaluated by the bucket (Pippenger) method.
+		// Its cost per point decreases with the number of points, whereas for the above per-point odd multiples it's constant.
+		static uint32_t s_BucketsMin;
+
+		// The casual and prepared terms are partitioned across nThreads (the calling thread included), the partial results are summed.
+		// The other nThreads-1 threads are spawned for the call.
+		void CalculateParallel(Point::Native&, uint32_t nThreads) const;
+
+	private:
+		void CalculateCasualBuckets(Point::Native&) const;
+		void get_Part(MultiMac&, uint32_t iPart, uint32_t nParts) const;
 	};
 
 	template <int nMaxCasual, int nMaxPrepared>
@@ -273,6 +287,45 @@ namespace ECC
 		}
 	};
 
+	struct PointCache
+	{
+		// Bounded cache of the decompressed points, keyed by the compressed form (saves the square root on the repeated imports).
+		// Direct-mapped: a new point evicts the one in its slot. Thread-safe.
+		struct Stats
+		{
+			uint64_t m_Lookups = 0;
+			uint64_t m_Hits = 0;
+			uint64_t m_Inserts = 0;
+		};
+
+		void Resize(size_t nBytes); // 0 - disabled. Drops the contents, must not be called concurrently with Import
+		bool IsEnabled() const { return !m_vSlots.empty(); }
+
+		// same as Point::Native::Import. If bInsert is set - the imported point is added on miss
+		bool Import(Point::Native&, const Point&, bool bInsert);
+
+		void get_Stats(Stats&) const;
+
+	private:
+		static const uint32_t s_Locks = 64;
+
+		struct Slot
+		{
+			Point m_Key;
+			bool m_bValid;
+			secp256k1_ge_storage m_Pt;
+		};
+
+		std::vector<Slot> m_vSlots; // power of 2
+		std::mutex m_pMutex[s_Locks];
+
+		std::atomic<uint64_t> m_Lookups{ 0 };
+		std::atomic<uint64_t> m_Hits{ 0 };
+		std::atomic<uint64_t> m_Inserts{ 0 };
+
+		size_t get_Slot(const Point&) const;
+	};
+
 	struct ScalarGenerator
 	{
 		// needed to quickly calculate power of a predefined scalar.
@@ -600,9 +653,11 @@ namespace ECC
 		void Reset();
 		void Calculate(Point::Native& res);
 
-		const uint32_t m_CasualTotal;
+		uint32_t m_CasualTotal;
 		bool m_bEnableBatch;
 		bool m_bDirty;
+		uint32_t m_nThreads; // max threads for the evaluation. Used if there are at least s_CasualPerThreadMin casual points per thread
+		static uint32_t s_CasualPerThreadMin;
 		Scalar::Native m_Multiplier; // must be initialized in a non-trivial way
 
 		bool AddCasual(const Point& p, const Scalar::Native& k);
@@ -614,8 +669,48 @@ namespace ECC
 
 		bool Flush();
 
+		// Optional. Records the equation boundaries, so that if the batch fails - the offending equations are identified (by bisection).
+		// Equations left incomplete (the verification aborted in the middle) are rolled-back and considered invalid as well.
+		// In this mode the auto-flush on overflow doesn't fail the current equation, and Flush() returns false if any invalid equation was found since the last Journal::Reset()
+		struct Journal
+		{
+			uint32_t m_iEquation; // number of equations begun so far
+			std::vector<uint32_t> m_vInvalid; // indexes of the invalid equations
+
+			Journal() { Reset(); }
+			void Reset();
+
+		private:
+			friend struct BatchContext;
+
+			struct Equation {
+				uint32_t m_iIdx;
+				uint32_t m_iCasual; // 1st casual point of this equation
+			};
+
+			// current batch
+			std::vector<Equation> m_vEqs;
+			std::vector<Scalar::Native> m_vPrepared; // s_CountPrepared per equation
+			bool m_bOpen;
+		};
+
+		Journal* m_pJournal;
+
+		virtual ~BatchContext() {}
+
 	protected:
 		BatchContext(uint32_t nCasualTotal);
+
+		// called when the equation doesn't fit. Should either enlarge the buffer (preserving its contents) or return false, then the batch is flushed
+		virtual bool Grow(uint32_t /* nCasualNeeded */) { return false; }
+
+	private:
+		void JournalBegin();
+		void JournalEnd();
+		void JournalRollback();
+		void FlushJournaled();
+		bool IsZeroJournaled(uint32_t iEq0, uint32_t iEq1);
+		void Bisect(uint32_t iEq0, uint32_t iEq1);
 	};
 
 	template <uint32_t nBatchSize>
@@ -631,6 +726,37 @@ namespace ECC
 		}
 	};
 
+	struct InnerProduct::BatchContextHeap
+		:public BatchContext
+	{
+		// Heap-backed, the capacity adapts to the number of proofs: grows on demand (instead of flushing) up to the specified max,
+		// and is trimmed back if the recent batches were much smaller.
+		BatchContextHeap(uint32_t nProofsInitial, uint32_t nProofsMax);
+
+		uint32_t get_ProofsMax() const { return m_CasualMax / s_CasualCountPerProof; }
+		size_t get_BufSize() const { return sizeof(MultiMac::Casual) * m_CasualTotal; }
+
+		// Call once per verification task (before the final flush). After s_TrimPeriod calls, if the peak usage within them stayed below
+		// a quarter of the capacity - the buffer is reallocated to twice the peak (not less than the initial size)
+		void Trim();
+		static const uint32_t s_TrimPeriod = 8;
+
+		// max batch size that fits the given memory budget
+		static uint32_t get_ProofsFor(size_t nBytes) { return static_cast<uint32_t>(nBytes / (sizeof(MultiMac::Casual) * s_CasualCountPerProof)); }
+
+	protected:
+		virtual bool Grow(uint32_t nCasualNeeded) override;
+
+	private:
+		std::unique_ptr<MultiMac::Casual[]> m_pBuf;
+		const uint32_t m_CasualMin;
+		const uint32_t m_CasualMax;
+		uint32_t m_CasualPeak; // within the current trim period
+		uint32_t m_nTrimCalls;
+
+		void Realloc(uint32_t nCasualTotal);
+	};
+
 	class Commitment
 	{
 		const Scalar::Native& k;
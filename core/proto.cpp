@@ -84,10 +84,19 @@ void ProtocolPlus::Encrypt(SerializedMsg& sm, MsgSerializer& ser)
 		ser & hmac;
 	}
 
+	bool bExternal = ser.has_external();
 	ser.finalize(sm);
 
 	if (Mode::Plaintext != m_Mode)
 	{
+		if (bExternal)
+		{
+			// encryption is in-place, external fragments must not be modified. Copy them (once)
+			io::SharedBuffer buf = io::normalize(sm, true);
+			sm.resize(1);
+			sm[0] = std::move(buf);
+		}
+
 		// 2. get size
 		size_t n = 0;
 
@@ -452,18 +461,55 @@ bool NodeConnection::IsLive() const
 	return m_Connection && !m_pAsyncFail;
 }
 
+void NodeConnection::SendInternal(MsgSerializer& ser)
+{
+	m_SerializeCache.clear();
+	m_Protocol.Encrypt(m_SerializeCache, ser);
+	io::Result res = m_Connection->write_msg(m_SerializeCache);
+	m_SerializeCache.clear();
+
+	TestIoResultAsync(res);
+}
+
+void NodeConnection::SendSerialized(uint8_t nCode, const io::SharedBuffer& buf)
+{
+	if (!IsLive())
+		return;
+
+	MsgSerializer& ser = m_Protocol.serializeBegin(nCode);
+	ser.append_external(buf);
+	SendInternal(ser);
+}
+
+void NodeConnection::SendBody(const io::SharedBuffer& bufP, const io::SharedBuffer& bufE)
+{
+	if (!IsLive())
+		return;
+
+	MsgSerializer& ser = m_Protocol.serializeBegin(Body::s_Code);
+	ser.write_external(bufP);
+	ser.write_external(bufE);
+	SendInternal(ser);
+}
+
+void NodeConnection::SendMacroblock(const Block::SystemState::ID& id, const io::SharedBuffer& bufPortion, uint64_t nSizeTotal)
+{
+	if (!IsLive())
+		return;
+
+	MsgSerializer& ser = m_Protocol.serializeBegin(Macroblock::s_Code);
+	ser & id;
+	ser.write_external(bufPortion);
+	ser & nSizeTotal;
+	SendInternal(ser);
+}
+
 #define THE_MACRO(code, msg) \
 void NodeConnection::Send(const msg& v) \
 { \
 	if (!IsLive()) \
 		return; \
-	m_SerializeCache.clear(); \
-	MsgSerializer& ser = m_Protocol.serializeNoFinalize(m_SerializeCache, uint8_t(code), v); \
-	m_Protocol.Encrypt(m_SerializeCache, ser); \
-	io::Result res = m_Connection->write_msg(m_SerializeCache); \
-	m_SerializeCache.clear(); \
-\
-	TestIoResultAsync(res); \
+	SendInternal(m_Protocol.serializeNoFinalize(m_SerializeCache, uint8_t(code), v)); \
 } \
 \
 bool NodeConnection::OnMsgInternal(uint64_t, msg##_NoInit&& v) \
@@ -425,6 +425,7 @@ namespace proto {
 #undef THE_MACRO
 
 		void HashAddNonce(ECC::Hash::Processor&, bool bRemote);
+		void SendInternal(MsgSerializer&);
 
 	public:
 
@@ -500,6 +501,11 @@ namespace proto {
 		BeamNodeMsgsAll(THE_MACRO)
 #undef THE_MACRO
 
+		// Same as Send(Body) and Send(Macroblock), the already-serialized data is referenced rather than copied
+		void SendBody(const io::SharedBuffer& bufP, const io::SharedBuffer& bufE);
+		void SendMacroblock(const Block::SystemState::ID&, const io::SharedBuffer& bufPortion, uint64_t nSizeTotal);
+		void SendSerialized(uint8_t nCode, const io::SharedBuffer&); // the message members are already serialized
+
 		struct Server
 		{
 			io::TcpServer::Ptr m_pServer; // just delete it to stop listening
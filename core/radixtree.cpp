@@ -43,11 +43,83 @@ void RadixTree::Clear()
 {
 	if (m_pRoot)
 	{
-		DeleteNode(m_pRoot);
+		if (!ReleaseAll())
+			DeleteNode(m_pRoot);
 		m_pRoot = NULL;
 	}
 }
 
+/////////////////////////////
+// RadixTree::Pool
+RadixTree::Pool::Pool(size_t nSize)
+	:m_pSlabs(NULL)
+	,m_pFree(NULL)
+	,m_pPos(NULL)
+	,m_pEnd(NULL)
+	,m_nSlabs(0)
+	,m_nUsed(0)
+{
+	// keep elements pointer-aligned
+	const size_t nAlign = sizeof(void*);
+	m_nSize = (std::max(nSize, sizeof(FreeItem)) + nAlign - 1) & ~(nAlign - 1);
+	assert(m_nSize + sizeof(Slab) <= s_SlabSize);
+}
+
+void* RadixTree::Pool::Alloc()
+{
+	if (m_pFree)
+	{
+		FreeItem* p = m_pFree;
+		m_pFree = p->m_pNext;
+		m_nUsed++;
+		return p;
+	}
+
+	if (m_pPos + m_nSize > m_pEnd)
+	{
+		uint8_t* pBuf = new uint8_t[s_SlabSize];
+
+		Slab* pSlab = reinterpret_cast<Slab*>(pBuf);
+		pSlab->m_pNext = m_pSlabs;
+		m_pSlabs = pSlab;
+		m_nSlabs++;
+
+		static_assert(!(sizeof(Slab) % sizeof(void*)), "");
+		m_pPos = pBuf + sizeof(Slab);
+		m_pEnd = pBuf + s_SlabSize;
+	}
+
+	void* pRet = m_pPos;
+	m_pPos += m_nSize;
+	m_nUsed++;
+	return pRet;
+}
+
+void RadixTree::Pool::Free(void* p)
+{
+	assert(p && m_nUsed);
+
+	FreeItem* pItem = reinterpret_cast<FreeItem*>(p);
+	pItem->m_pNext = m_pFree;
+	m_pFree = pItem;
+	m_nUsed--;
+}
+
+void RadixTree::Pool::Release()
+{
+	while (m_pSlabs)
+	{
+		Slab* p = m_pSlabs;
+		m_pSlabs = p->m_pNext;
+		delete[] reinterpret_cast<uint8_t*>(p);
+	}
+
+	m_pFree = NULL;
+	m_pPos = m_pEnd = NULL;
+	m_nSlabs = 0;
+	m_nUsed = 0;
+}
+
 void RadixTree::DeleteNode(Node* p)
 {
 	if (Node::s_Leaf & p->m_Bits)
@@ -443,6 +515,29 @@ size_t RadixTree::Count() const
 
 /////////////////////////////
 // RadixHashTree
+RadixHashTree::RadixHashTree(size_t nSizeLeaf)
+	:m_PoolJoints(sizeof(MyJoint))
+	,m_PoolLeafs(nSizeLeaf)
+{
+}
+
+bool RadixHashTree::ReleaseAll()
+{
+	// nodes are trivially destructible, no need to visit them
+	static_assert(std::is_trivially_destructible<MyJoint>::value, "");
+	static_assert(std::is_trivially_destructible<RadixHashOnlyTree::MyLeaf>::value, "");
+	static_assert(std::is_trivially_destructible<UtxoTree::MyLeaf>::value, "");
+
+	m_PoolJoints.Release();
+	m_PoolLeafs.Release();
+	return true;
+}
+
+size_t RadixHashTree::get_MemoryUsage() const
+{
+	return m_PoolJoints.get_Reserved() + m_PoolLeafs.get_Reserved();
+}
+
 void RadixHashTree::get_Hash(Merkle::Hash& hv)
 {
 	Node* p = get_Root();
@@ -479,6 +574,54 @@ const Merkle::Hash& RadixHashTree::get_Hash(Node& n, Merkle::Hash& hv)
 	return x.m_Hash;
 }
 
+void RadixHashTree::get_DirtySubtrees(DirtyList& v, size_t nMin)
+{
+	v.clear();
+
+	Node* p = get_Root();
+	if (!p || (Node::s_Clean & p->m_Bits))
+		return;
+
+	v.push_back(p);
+
+	for (DirtyList vNext; v.size() < nMin; v.swap(vNext))
+	{
+		bool bExpanded = false;
+		vNext.clear();
+
+		for (size_t i = 0; i < v.size(); i++)
+		{
+			Node* pN = v[i];
+			if (Node::s_Leaf & pN->m_Bits)
+			{
+				vNext.push_back(pN);
+				continue;
+			}
+
+			bExpanded = true; // this joint will be evaluated by get_Hash()
+
+			Joint& x = Cast::Up<Joint>(*pN);
+			for (size_t j = 0; j < _countof(x.m_ppC); j++)
+				if (!(Node::s_Clean & x.m_ppC[j]->m_Bits))
+					vNext.push_back(x.m_ppC[j]);
+		}
+
+		if (!bExpanded)
+			break;
+	}
+}
+
+void RadixHashTree::HashDirty(const DirtyList& v, uint32_t iThread, uint32_t nThreads)
+{
+	assert(nThreads);
+
+	for (size_t i = iThread; i < v.size(); i += nThreads)
+	{
+		Merkle::Hash hv;
+		get_Hash(*v[i], hv);
+	}
+}
+
 void RadixHashTree::get_Proof(Merkle::Proof& proof, const CursorBase& cu)
 {
 	uint16_t n = cu.get_Depth();
@@ -626,4 +769,497 @@ UtxoTree::Key& UtxoTree::Key::operator = (const Data& d)
 	return *this;
 }
 
+/////////////////////////////
+// UtxoTreeCompact
+namespace
+{
+	uint8_t CountBits(uint32_t x)
+	{
+		uint8_t n = 0;
+		for (; x; n++)
+			x &= x - 1;
+		return n;
+	}
+
+	// nibble values with the specified bit set (starting from the MSB)
+	const uint16_t s_pMaskHi[] = { 0xff00, 0xf0f0, 0xcccc, 0xaaaa };
+}
+
+UtxoTreeCompact::UtxoTreeCompact()
+	:m_pRoot(NULL)
+	,m_nCount(0)
+	,m_PoolLeafs(sizeof(MyLeaf))
+	,m_pPoolJoints{
+		RadixTree::Pool(sizeof(Joint) - sizeof(Node*) * (0x10 - 2)),
+		RadixTree::Pool(sizeof(Joint) - sizeof(Node*) * (0x10 - 4)),
+		RadixTree::Pool(sizeof(Joint) - sizeof(Node*) * (0x10 - 8)),
+		RadixTree::Pool(sizeof(Joint)) }
+{
+}
+
+void UtxoTreeCompact::Clear()
+{
+	// nodes are trivially destructible, no need to visit them
+	static_assert(std::is_trivially_destructible<MyLeaf>::value, "");
+	static_assert(std::is_trivially_destructible<Joint>::value, "");
+
+	m_pRoot = NULL;
+	m_nCount = 0;
+
+	m_PoolLeafs.Release();
+	for (size_t i = 0; i < _countof(m_pPoolJoints); i++)
+		m_pPoolJoints[i].Release();
+}
+
+size_t UtxoTreeCompact::get_MemoryUsage() const
+{
+	size_t nRet = m_PoolLeafs.get_Reserved();
+	for (size_t i = 0; i < _countof(m_pPoolJoints); i++)
+		nRet += m_pPoolJoints[i].get_Reserved();
+	return nRet;
+}
+
+UtxoTreeCompact::MyLeaf& UtxoTreeCompact::Cursor::get_Leaf() const
+{
+	assert(m_nPtrs);
+	Node* p = m_pp[m_nPtrs - 1];
+	assert(Node::s_Leaf & p->m_Flags);
+	return Cast::Up<MyLeaf>(*p);
+}
+
+void UtxoTreeCompact::Cursor::InvalidateElement()
+{
+	for (uint32_t n = m_nPtrs; n--; )
+	{
+		Node* p = m_pp[n];
+		assert(p);
+
+		if (!(Node::s_Clean & p->m_Flags))
+			break;
+
+		p->m_Flags &= ~Node::s_Clean;
+	}
+}
+
+uint8_t UtxoTreeCompact::get_Nibble(const Key& key, uint8_t iNibble)
+{
+	assert(iNibble < s_Nibbles);
+	uint8_t x = key.m_pArr[iNibble >> 1];
+	return (1 & iNibble) ? (0xf & x) : (x >> 4);
+}
+
+uint8_t UtxoTreeCompact::get_NodeNibble(const Node& n)
+{
+	return (Node::s_Leaf & n.m_Flags) ? s_Nibbles : Cast::Up<Joint>(n).m_iNibble;
+}
+
+const UtxoTreeCompact::Key& UtxoTreeCompact::get_AnyKey(const Node& n)
+{
+	const Node* p = &n;
+	while (!(Node::s_Leaf & p->m_Flags))
+		p = Cast::Up<Joint>(p)->m_ppC[0];
+
+	return Cast::Up<MyLeaf>(p)->m_Key;
+}
+
+uint8_t UtxoTreeCompact::get_ChildIdx(const Joint& x, uint8_t nNibble)
+{
+	return CountBits(x.m_Mask & ((1U << nNibble) - 1));
+}
+
+int UtxoTreeCompact::CmpNibbles(const Key& k1, const Key& k2, uint8_t nNibbles)
+{
+	int nCmp = memcmp(k1.m_pArr, k2.m_pArr, nNibbles >> 1);
+	if (nCmp || !(1 & nNibbles))
+		return nCmp;
+
+	uint8_t a = k1.m_pArr[nNibbles >> 1] >> 4;
+	uint8_t b = k2.m_pArr[nNibbles >> 1] >> 4;
+	return (a < b) ? -1 : (a > b);
+}
+
+UtxoTreeCompact::Joint* UtxoTreeCompact::CreateJoint(uint8_t iCapacity)
+{
+	assert(iCapacity < s_CapacityClasses);
+	Joint* p = new (m_pPoolJoints[iCapacity].Alloc()) Joint;
+
+	p->m_Flags = 0;
+	p->m_iCapacity = iCapacity;
+	p->m_Mask = 0;
+	return p;
+}
+
+void UtxoTreeCompact::DeleteJoint(Joint* p)
+{
+	m_pPoolJoints[p->m_iCapacity].Free(p);
+}
+
+void UtxoTreeCompact::ReplaceNode(Cursor& cu, uint32_t iPos, Node* pNew)
+{
+	assert(iPos < cu.m_nPtrs);
+	Node* pOld = cu.m_pp[iPos];
+
+	if (iPos)
+	{
+		Joint& x = Cast::Up<Joint>(*cu.m_pp[iPos - 1]);
+		for (uint8_t i = 0; ; i++)
+		{
+			assert(i < CountBits(x.m_Mask));
+			if (x.m_ppC[i] == pOld)
+			{
+				x.m_ppC[i] = pNew;
+				break;
+			}
+		}
+	}
+	else
+	{
+		assert(m_pRoot == pOld);
+		m_pRoot = pNew;
+	}
+
+	cu.m_pp[iPos] = pNew;
+}
+
+UtxoTreeCompact::Joint* UtxoTreeCompact::ResizeJoint(Cursor& cu, uint32_t iPos, uint8_t iCapacity)
+{
+	Joint& x = Cast::Up<Joint>(*cu.m_pp[iPos]);
+	assert(CountBits(x.m_Mask) <= (2U << iCapacity));
+
+	Joint* pNew = CreateJoint(iCapacity);
+	pNew->m_Flags = x.m_Flags;
+	pNew->m_iNibble = x.m_iNibble;
+	pNew->m_Mask = x.m_Mask;
+	pNew->m_Hash = x.m_Hash;
+	memcpy(pNew->m_ppC, x.m_ppC, sizeof(Node*) * CountBits(x.m_Mask));
+
+	ReplaceNode(cu, iPos, pNew);
+	DeleteJoint(&x);
+
+	return pNew;
+}
+
+UtxoTreeCompact::MyLeaf* UtxoTreeCompact::Find(Cursor& cu, const Key& key, bool& bCreate)
+{
+	cu.m_nPtrs = 0;
+
+	Node* p = m_pRoot;
+	if (p)
+	{
+		// descend as far as possible, the compressed nibbles are not checked
+		while (true)
+		{
+			cu.m_pp[cu.m_nPtrs++] = p;
+			if (Node::s_Leaf & p->m_Flags)
+				break;
+
+			Joint& x = Cast::Up<Joint>(*p);
+			uint8_t nNibble = get_Nibble(key, x.m_iNibble);
+			if (!((1U << nNibble) & x.m_Mask))
+				break;
+
+			p = x.m_ppC[get_ChildIdx(x, nNibble)];
+		}
+	}
+
+	// find the 1st differing nibble
+	uint8_t iNibble = s_Nibbles;
+	const Key* pKey1 = p ? &get_AnyKey(*p) : NULL;
+
+	if (pKey1)
+	{
+		for (uint8_t i = 0; i < Key::s_Bytes; i++)
+		{
+			uint8_t d = key.m_pArr[i] ^ pKey1->m_pArr[i];
+			if (d)
+			{
+				iNibble = (i << 1) + !(0xf0 & d);
+				break;
+			}
+		}
+
+		if (s_Nibbles == iNibble)
+		{
+			assert(Node::s_Leaf & p->m_Flags);
+			bCreate = false;
+			return Cast::Up<MyLeaf>(p);
+		}
+	}
+
+	if (!bCreate)
+		return NULL;
+
+	MyLeaf* pN = new (m_PoolLeafs.Alloc()) MyLeaf;
+	pN->m_Flags = Node::s_Leaf;
+	pN->m_Key = key;
+
+	if (pKey1)
+	{
+		// the insertion point: the 1st node on the path that doesn't precede the differing nibble
+		uint32_t iPos = 0;
+		while (get_NodeNibble(*cu.m_pp[iPos]) < iNibble)
+			iPos++;
+		assert(iPos < cu.m_nPtrs);
+
+		uint8_t nNibble = get_Nibble(key, iNibble);
+
+		try
+		{
+			if (get_NodeNibble(*cu.m_pp[iPos]) == iNibble)
+			{
+				// add to the existing joint
+				cu.m_nPtrs = iPos + 1;
+				cu.InvalidateElement();
+
+				Joint* pJ = &Cast::Up<Joint>(*cu.m_pp[iPos]);
+				uint8_t nCount = CountBits(pJ->m_Mask);
+				assert(!((1U << nNibble) & pJ->m_Mask));
+
+				if ((2U << pJ->m_iCapacity) == nCount)
+					pJ = ResizeJoint(cu, iPos, pJ->m_iCapacity + 1);
+
+				uint8_t iIdx = get_ChildIdx(*pJ, nNibble);
+				memmove(pJ->m_ppC + iIdx + 1, pJ->m_ppC + iIdx, sizeof(Node*) * (nCount - iIdx));
+				pJ->m_ppC[iIdx] = pN;
+				pJ->m_Mask |= (1U << nNibble);
+			}
+			else
+			{
+				// split
+				cu.m_nPtrs = iPos;
+				cu.InvalidateElement();
+				cu.m_nPtrs++;
+
+				Joint* pJ = CreateJoint(0);
+				pJ->m_iNibble = iNibble;
+
+				uint8_t nNibble1 = get_Nibble(*pKey1, iNibble);
+				pJ->m_Mask = (1U << nNibble) | (1U << nNibble1);
+
+				bool b = (nNibble > nNibble1);
+				pJ->m_ppC[b] = pN;
+				pJ->m_ppC[!b] = cu.m_pp[iPos];
+
+				ReplaceNode(cu, iPos, pJ);
+			}
+		}
+		catch (...)
+		{
+			m_PoolLeafs.Free(pN);
+			throw;
+		}
+	}
+	else
+		m_pRoot = pN;
+
+	cu.m_pp[cu.m_nPtrs++] = pN;
+	m_nCount++;
+
+	return pN;
+}
+
+void UtxoTreeCompact::Delete(Cursor& cu)
+{
+	cu.InvalidateElement();
+
+	MyLeaf* p = &cu.get_Leaf();
+	cu.m_nPtrs--;
+
+	if (cu.m_nPtrs)
+	{
+		uint32_t iPos = cu.m_nPtrs - 1;
+		Joint* pJ = &Cast::Up<Joint>(*cu.m_pp[iPos]);
+
+		uint8_t nNibble = get_Nibble(p->m_Key, pJ->m_iNibble);
+		uint8_t iIdx = get_ChildIdx(*pJ, nNibble);
+		assert(pJ->m_ppC[iIdx] == p);
+
+		uint8_t nCount = CountBits(pJ->m_Mask) - 1;
+		memmove(pJ->m_ppC + iIdx, pJ->m_ppC + iIdx + 1, sizeof(Node*) * (nCount - iIdx));
+		pJ->m_Mask &= ~(1U << nNibble);
+
+		if (1 == nCount)
+		{
+			// the joint is no longer needed
+			ReplaceNode(cu, iPos, pJ->m_ppC[0]);
+			DeleteJoint(pJ);
+			cu.m_nPtrs--;
+		}
+		else
+			if (pJ->m_iCapacity && (nCount <= (1U << (pJ->m_iCapacity - 1))))
+				ResizeJoint(cu, iPos, pJ->m_iCapacity - 1); // shrink, leave some room to avoid oscillations
+	}
+	else
+	{
+		assert(m_pRoot == p);
+		m_pRoot = NULL;
+	}
+
+	m_PoolLeafs.Free(p);
+	m_nCount--;
+}
+
+void UtxoTreeCompact::get_Hash(Merkle::Hash& hv)
+{
+	if (m_pRoot)
+		hv = get_Hash(*m_pRoot, hv);
+	else
+		hv = Zero;
+}
+
+const Merkle::Hash& UtxoTreeCompact::get_Hash(Node& n, Merkle::Hash& hv)
+{
+	if (Node::s_Leaf & n.m_Flags)
+	{
+		MyLeaf& x = Cast::Up<MyLeaf>(n);
+		x.m_Value.get_Hash(hv, x.m_Key);
+		x.m_Flags |= Node::s_Clean;
+		return hv;
+	}
+
+	Joint& x = Cast::Up<Joint>(n);
+	if (!(Node::s_Clean & x.m_Flags))
+	{
+		Merkle::Hash hvPlaceholder;
+		x.m_Hash = get_Hash(x, x.m_Mask, 0, hvPlaceholder);
+		x.m_Flags |= Node::s_Clean;
+	}
+
+	return x.m_Hash;
+}
+
+const Merkle::Hash& UtxoTreeCompact::get_Hash(Joint& x, uint16_t nMask, uint8_t iBit, Merkle::Hash& hv)
+{
+	assert(nMask);
+
+	if (!(nMask & (nMask - 1)))
+	{
+		// single child, no binary joint
+		uint8_t nNibble = 0;
+		while (!((1U << nNibble) & nMask))
+			nNibble++;
+
+		return get_Hash(*x.m_ppC[get_ChildIdx(x, nNibble)], hv);
+	}
+
+	for (; ; iBit++)
+	{
+		assert(iBit < _countof(s_pMaskHi));
+
+		uint16_t nMaskHi = nMask & s_pMaskHi[iBit];
+		if (nMaskHi && (nMaskHi != nMask))
+		{
+			// binary joint
+			ECC::Hash::Value hv0, hv1;
+			ECC::Hash::Processor()
+				<< get_Hash(x, nMask & ~nMaskHi, iBit + 1, hv0)
+				<< get_Hash(x, nMaskHi, iBit + 1, hv1)
+				>> hv;
+
+			return hv;
+		}
+	}
+}
+
+void UtxoTreeCompact::get_Proof(Merkle::Proof& proof, const Cursor& cu)
+{
+	const Key& key = cu.get_Leaf().m_Key;
+
+	for (uint32_t iPos = cu.m_nPtrs - 1; iPos--; )
+	{
+		Joint& x = Cast::Up<Joint>(*cu.m_pp[iPos]);
+		uint8_t nNibble = get_Nibble(key, x.m_iNibble);
+
+		// emulate the binary joints within the nibble, bottom-up
+		for (uint8_t iBit = _countof(s_pMaskHi); iBit--; )
+		{
+			// children that share the upper iBit bits with our nibble
+			uint8_t nShift = static_cast<uint8_t>(_countof(s_pMaskHi) - iBit);
+			uint16_t nGroup = static_cast<uint16_t>(((1U << (1U << nShift)) - 1) << ((nNibble >> nShift) << nShift));
+
+			uint16_t nMaskHi = nGroup & s_pMaskHi[iBit];
+			bool bHi = ((1U << nNibble) & nMaskHi) != 0;
+
+			uint16_t nMaskSibling = x.m_Mask & (bHi ? (nGroup & ~nMaskHi) : nMaskHi);
+			if (!nMaskSibling)
+				continue;
+
+			proof.resize(proof.size() + 1);
+			Merkle::Node& node = proof.back();
+
+			node.first = !bHi;
+			node.second = get_Hash(x, nMaskSibling, iBit + 1, node.second);
+		}
+	}
+}
+
+bool UtxoTreeCompact::Traverse(ITraveler& t) const
+{
+	if (!m_pRoot)
+		return true;
+
+	Cursor cuDummy;
+	Cursor& cu = t.m_pCu ? *t.m_pCu : cuDummy;
+	cu.m_nPtrs = 0;
+
+	const Key* pBound[_countof(t.m_pBound)];
+	memcpy(pBound, t.m_pBound, sizeof(pBound));
+
+	Cursor* pCu = t.m_pCu;
+	t.m_pCu = &cu;
+
+	bool bRet = Traverse(*m_pRoot, t, pBound);
+
+	t.m_pCu = pCu;
+	return bRet;
+}
+
+bool UtxoTreeCompact::Traverse(const Node& n, ITraveler& t, const Key** pBound) const
+{
+	Cursor& cu = *t.m_pCu;
+	uint32_t nPtrs = cu.m_nPtrs;
+	cu.m_pp[cu.m_nPtrs++] = Cast::NotConst(&n);
+
+	const Key* pB[_countof(t.m_pBound)];
+	memcpy(pB, pBound, sizeof(pB));
+
+	if (pB[0] || pB[1])
+	{
+		// all the elements of the subtree share the nibbles up to the node's one
+		const Key& key = get_AnyKey(n);
+		uint8_t nNibbles = get_NodeNibble(n);
+
+		for (size_t iBound = 0; iBound < _countof(pB); iBound++)
+		{
+			if (!pB[iBound])
+				continue;
+
+			int nCmp = CmpNibbles(key, *pB[iBound], nNibbles);
+			if (!nCmp)
+				continue;
+
+			if ((nCmp < 0) == !iBound)
+			{
+				cu.m_nPtrs = nPtrs;
+				return true; // out of bounds
+			}
+
+			pB[iBound] = NULL; // the whole subtree is within this bound
+		}
+	}
+
+	if (Node::s_Leaf & n.m_Flags)
+		return t.OnLeaf(Cast::Up<MyLeaf>(n));
+
+	const Joint& x = Cast::Up<Joint>(n);
+	for (uint8_t i = 0, nCount = CountBits(x.m_Mask); i < nCount; i++)
+	{
+		cu.m_nPtrs = nPtrs + 1;
+		if (!Traverse(*x.m_ppC[i], t, pB))
+			return false;
+	}
+
+	return true;
+}
+
 } // namespace beam
@@ -52,9 +52,44 @@ protected:
 	virtual uint8_t* GetLeafKey(const Leaf&) const = 0;
 	virtual void DeleteJoint(Joint*) = 0;
 	virtual void DeleteLeaf(Leaf*) = 0;
+	virtual bool ReleaseAll() { return false; } // release all the nodes at once, without the traversal. Return false if not supported
 
 public:
 
+	// Fixed-size allocator. Elements are carved from big slabs, freed elements are kept in a free-list for reuse.
+	// Element destructors are not called on Release(), so it should only be used for trivially destructible types.
+	class Pool
+	{
+		struct Slab {
+			Slab* m_pNext;
+		};
+
+		struct FreeItem {
+			FreeItem* m_pNext;
+		};
+
+		Slab* m_pSlabs;
+		FreeItem* m_pFree;
+		uint8_t* m_pPos; // unused tail of the most recent slab
+		uint8_t* m_pEnd;
+		size_t m_nSize;
+		size_t m_nSlabs;
+		size_t m_nUsed;
+
+	public:
+		static const size_t s_SlabSize = 0x10000;
+
+		Pool(size_t nSize);
+		~Pool() { Release(); }
+
+		void* Alloc();
+		void Free(void*);
+		void Release(); // returns all the slabs to the heap
+
+		size_t get_Used() const { return m_nUsed; } // elements
+		size_t get_Reserved() const { return m_nSlabs * s_SlabSize; } // bytes
+	};
+
 	RadixTree();
 	~RadixTree();
 
@@ -144,10 +179,25 @@ public:
 	void get_Hash(Merkle::Hash&);
 	void get_Proof(Merkle::Proof&, const CursorBase&);
 
+	size_t get_MemoryUsage() const; // heap memory reserved for the nodes
+
+	// Parallel rehash. The dirty part of the tree is split into independent subtrees, which may be hashed concurrently
+	// (no other access to the tree is allowed meanwhile). Afterwards get_Hash() only evaluates the joints above them,
+	// and the result is identical to the serial evaluation.
+	typedef std::vector<Node*> DirtyList;
+	void get_DirtySubtrees(DirtyList&, size_t nMin); // splits until there are at least nMin subtrees, if possible
+	void HashDirty(const DirtyList&, uint32_t iThread, uint32_t nThreads);
+
 protected:
+	RadixHashTree(size_t nSizeLeaf);
+
+	Pool m_PoolJoints;
+	Pool m_PoolLeafs; // the derived class must allocate its leaves from it
+
 	// RadixTree
-	virtual Joint* CreateJoint() override { return new MyJoint; }
-	virtual void DeleteJoint(Joint* p) override { delete Cast::Up<MyJoint>(p); }
+	virtual Joint* CreateJoint() override { return new (m_PoolJoints.Alloc()) MyJoint; }
+	virtual void DeleteJoint(Joint* p) override { m_PoolJoints.Free(Cast::Up<MyJoint>(p)); }
+	virtual bool ReleaseAll() override;
 
 	const Merkle::Hash& get_Hash(Node&, Merkle::Hash&);
 
@@ -174,12 +224,13 @@ public:
 		return Cast::Up<MyLeaf>(RadixTree::Find(cu, key.m_pData, ECC::nBits, bCreate));
 	}
 
+	RadixHashOnlyTree() :RadixHashTree(sizeof(MyLeaf)) {}
 	~RadixHashOnlyTree() { Clear(); }
 
 protected:
-	virtual Leaf* CreateLeaf() override { return new MyLeaf; }
+	virtual Leaf* CreateLeaf() override { return new (m_PoolLeafs.Alloc()) MyLeaf; }
 	virtual uint8_t* GetLeafKey(const Leaf& x) const override { return Cast::Up<MyLeaf>(Cast::NotConst(x)).m_Hash.m_pData; }
-	virtual void DeleteLeaf(Leaf* p) override { delete Cast::Up<MyLeaf>(p); }
+	virtual void DeleteLeaf(Leaf* p) override { m_PoolLeafs.Free(Cast::Up<MyLeaf>(p)); }
 	virtual const Merkle::Hash& get_LeafHash(Node& n, Merkle::Hash&) override { return Cast::Up<MyLeaf>(n).m_Hash; }
 };
 
@@ -233,6 +284,7 @@ public:
 		return Cast::Up<MyLeaf>(RadixTree::Find(cu, key.m_pArr, key.s_Bits, bCreate));
 	}
 
+	UtxoTree() :RadixHashTree(sizeof(MyLeaf)) {}
 	~UtxoTree() { Clear(); }
 
     template<typename Archive>
@@ -253,9 +305,9 @@ public:
 
 
 protected:
-	virtual Leaf* CreateLeaf() override { return new MyLeaf; }
+	virtual Leaf* CreateLeaf() override { return new (m_PoolLeafs.Alloc()) MyLeaf; }
 	virtual uint8_t* GetLeafKey(const Leaf& x) const override { return Cast::Up<MyLeaf>(Cast::NotConst(x)).m_Key.m_pArr; }
-	virtual void DeleteLeaf(Leaf* p) override { delete Cast::Up<MyLeaf>(p); }
+	virtual void DeleteLeaf(Leaf* p) override { m_PoolLeafs.Free(Cast::Up<MyLeaf>(p)); }
 	virtual const Merkle::Hash& get_LeafHash(Node&, Merkle::Hash&) override;
 
 	struct ISerializer {
@@ -278,4 +330,104 @@ protected:
 	void LoadIntenral(ISerializer&);
 };
 
+class UtxoTreeCompact
+{
+public:
+
+	// Alternative UTXO tree layout: 16-way (nibble) path-compressed nodes with contiguous child arrays.
+	// Keys, values and the Merkle root are the same as in UtxoTree: the hash of each node is evaluated
+	// as if it was expanded into the binary radix tree, so that proofs are interchangeable.
+
+	typedef UtxoTree::Key Key;
+	typedef UtxoTree::Value Value;
+
+	static const uint8_t s_Nibbles = Key::s_Bytes * 2;
+
+	struct Node
+	{
+		uint8_t m_Flags;
+		static const uint8_t s_Leaf = 1;
+		static const uint8_t s_Clean = 2;
+	};
+
+	struct MyLeaf :public Node
+	{
+		Key m_Key;
+		Value m_Value;
+	};
+
+	struct Cursor
+	{
+		Node* m_pp[s_Nibbles + 1];
+		uint32_t m_nPtrs;
+
+		MyLeaf& get_Leaf() const;
+		void InvalidateElement();
+	};
+
+	UtxoTreeCompact();
+	~UtxoTreeCompact() { Clear(); }
+
+	void Clear();
+
+	MyLeaf* Find(Cursor&, const Key&, bool& bCreate);
+	void Delete(Cursor&);
+
+	struct ITraveler
+	{
+		Cursor* m_pCu; // optional, receives the path to each element during traverse
+		const Key* m_pBound[2]; // optional min/max bounds
+
+		ITraveler()
+			:m_pCu(NULL)
+		{
+			ZeroObject(m_pBound);
+		}
+
+		virtual bool OnLeaf(const MyLeaf&) = 0; // return false to stop iteration
+	};
+
+	bool Traverse(ITraveler&) const;
+
+	void get_Hash(Merkle::Hash&);
+	void get_Proof(Merkle::Proof&, const Cursor&);
+
+	size_t Count() const { return m_nCount; }
+	size_t get_MemoryUsage() const;
+
+private:
+
+	struct Joint :public Node
+	{
+		uint8_t m_iNibble; // the nibble that distinguishes the children. All the preceeding ones are the same
+		uint8_t m_iCapacity; // index of the capacity class
+		uint16_t m_Mask; // present children
+		Merkle::Hash m_Hash;
+		Node* m_ppC[0x10]; // sorted by the nibble value. Only the part that fits the capacity is allocated
+	};
+
+	static const uint8_t s_CapacityClasses = 4; // 2, 4, 8, 16 children
+
+	Node* m_pRoot;
+	size_t m_nCount;
+	RadixTree::Pool m_PoolLeafs;
+	RadixTree::Pool m_pPoolJoints[s_CapacityClasses];
+
+	static uint8_t get_Nibble(const Key&, uint8_t iNibble);
+	static uint8_t get_NodeNibble(const Node&);
+	static const Key& get_AnyKey(const Node&);
+	static uint8_t get_ChildIdx(const Joint&, uint8_t nNibble);
+	static int CmpNibbles(const Key&, const Key&, uint8_t nNibbles);
+
+	Joint* CreateJoint(uint8_t iCapacity);
+	void DeleteJoint(Joint*);
+	void ReplaceNode(Cursor&, uint32_t iPos, Node* pNew);
+	Joint* ResizeJoint(Cursor&, uint32_t iPos, uint8_t iCapacity);
+
+	const Merkle::Hash& get_Hash(Node&, Merkle::Hash&);
+	const Merkle::Hash& get_Hash(Joint&, uint16_t nMask, uint8_t iBit, Merkle::Hash&); // the subset of children (within the nibble)
+
+	bool Traverse(const Node&, ITraveler&, const Key** pBound) const;
+};
+
 } // namespace beam
@@ -20,6 +20,8 @@
 #include "../serialization_adapters.h"
 #include "../aes.h"
 #include "../proto.h"
+#include "../radixtree.h"
+#include <thread>
 
 #if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
 #pragma GCC diagnostic ignored "-Wunused-result"
@@ -389,6 +391,94 @@ void TestPoints()
 	p1 = -p1;
 	p1 += p0;
 	verify_test(p1 == Zero);
+
+	// MultiMac: bucket method vs per-point odd multiples, including zero points and scalars
+	{
+		const int nCount = 300;
+		typedef MultiMac_WithBufs<nCount, 1> MyMultiMac;
+		std::unique_ptr<MyMultiMac> pMm(new MyMultiMac);
+
+		for (int i = 0; i < nCount; i++)
+		{
+			SetRandom(s0);
+			p0 = g * s0;
+			if (!(i % 50))
+				p0 = Zero;
+
+			SetRandom(s1);
+			if (!(i % 70))
+				s1 = Zero;
+
+			pMm->m_pCasual[pMm->m_Casual++].Init(p0, s1);
+		}
+
+		const uint32_t nBucketsMin = MultiMac::s_BucketsMin;
+
+		MultiMac::s_BucketsMin = nCount + 1;
+		pMm->Calculate(p0);
+
+		MultiMac::s_BucketsMin = nCount;
+		pMm->Calculate(p1);
+
+		MultiMac::s_BucketsMin = nBucketsMin;
+
+		p1 = -p1;
+		p1 += p0;
+		verify_test(p1 == Zero);
+
+		// parallel evaluation, the parts must sum up to the same result
+		for (uint32_t nThreads = 2; nThreads <= 5; nThreads++)
+		{
+			pMm->CalculateParallel(p1, nThreads);
+
+			p1 = -p1;
+			p1 += p0;
+			verify_test(p1 == Zero);
+		}
+	}
+
+	// decompressed points cache
+	{
+		PointCache pc;
+		pc.Resize(1024 * 16);
+		verify_test(pc.IsEnabled());
+
+		const uint32_t nCount = 20;
+		Point pPts[nCount];
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			SetRandom(s0);
+			p0 = g * s0;
+			p0.Export(pPts[i]);
+
+			verify_test(pc.Import(p1, pPts[i], true)); // miss, inserted
+			p1 = -p1;
+			p1 += p0;
+			verify_test(p1 == Zero);
+		}
+
+		for (uint32_t i = 0; i < nCount; i++)
+		{
+			verify_test(p0.Import(pPts[i]));
+			verify_test(pc.Import(p1, pPts[i], false)); // hit, unless evicted
+			p1 = -p1;
+			p1 += p0;
+			verify_test(p1 == Zero);
+		}
+
+		Point pt;
+		ZeroObject(pt);
+		verify_test(pc.Import(p1, pt, true) && (p1 == Zero));
+
+		pt.m_Y = 2; // ill-formed
+		verify_test(!pc.Import(p1, pt, true));
+
+		PointCache::Stats st;
+		pc.get_Stats(st);
+		verify_test(st.m_Lookups == nCount * 2 + 2);
+		verify_test(st.m_Inserts == nCount);
+		verify_test(st.m_Hits && (st.m_Hits <= nCount));
+	}
 }
 
 void TestSigning()
@@ -433,6 +523,77 @@ void TestSigning()
 		SetRandom(mysig2.m_k.m_Value);
 		verify_test(!mysig2.IsValid(msg, pk));
 	}
+
+	// batch verification
+	InnerProduct::BatchContextEx<2> bc;
+	bc.m_bEnableBatch = true;
+	InnerProduct::BatchContext::Scope scope(bc);
+
+	for (int iTamper = -1; iTamper < 10; iTamper++)
+	{
+		for (int i = 0; i < 10; i++)
+		{
+			Scalar::Native sk;
+			SetRandom(sk);
+
+			Point::Native pk = Context::get().G * sk;
+
+			uintBig msg;
+			SetRandom(msg);
+
+			Signature mysig;
+			mysig.Sign(msg, sk);
+
+			if (i == iTamper)
+				msg.Inc();
+
+			verify_test(mysig.IsValid(msg, pk)); // deferred
+		}
+
+		verify_test(bc.Flush() == (iTamper < 0));
+		bc.Reset();
+	}
+
+	// journaled batch: the invalid signatures must be identified
+	InnerProduct::BatchContext::Journal jrnl;
+	bc.m_pJournal = &jrnl;
+
+	for (int iTamper = -1; iTamper < 10; iTamper++)
+	{
+		const int iTamper2 = 13;
+		jrnl.Reset();
+
+		for (int i = 0; i < 20; i++) // exceeds the batch capacity, auto-flushes on the way
+		{
+			Scalar::Native sk;
+			SetRandom(sk);
+
+			Point::Native pk = Context::get().G * sk;
+
+			uintBig msg;
+			SetRandom(msg);
+
+			Signature mysig;
+			mysig.Sign(msg, sk);
+
+			if ((i == iTamper) || (i == iTamper2))
+				msg.Inc();
+
+			verify_test(mysig.IsValid(msg, pk)); // deferred
+		}
+
+		verify_test(!bc.Flush());
+		verify_test(jrnl.m_iEquation == 20);
+
+		std::vector<uint32_t> vExpected;
+		if (iTamper >= 0)
+			vExpected.push_back(iTamper);
+		vExpected.push_back(iTamper2);
+
+		verify_test(jrnl.m_vInvalid == vExpected);
+	}
+
+	bc.m_pJournal = NULL;
 }
 
 void TestCommitments()
@@ -607,6 +768,84 @@ void TestRangeProof()
 
 	verify_test(bc.Flush()); // verify at once
 
+	{
+		// interleave with signatures, so that proofs don't align with the batch boundaries
+		InnerProduct::BatchContext::Scope scope(bc);
+
+		Point::Native pk = Context::get().G * sk;
+		uintBig msg;
+		SetRandom(msg);
+
+		Signature sig;
+		sig.Sign(msg, sk);
+
+		for (int i = 0; i < 5; i++)
+		{
+			verify_test(sig.IsValid(msg, pk));
+
+			Oracle oracle;
+			verify_test(bp.IsValid(comm, oracle, bc));
+		}
+
+		verify_test(bc.Flush());
+	}
+
+	{
+		// heap batch, grows on demand, then flushes
+		InnerProduct::BatchContextHeap bch(1, 3);
+		bch.m_bEnableBatch = true;
+		verify_test(bch.get_ProofsMax() == 3);
+
+		for (int i = 0; i < 5; i++)
+		{
+			Oracle oracle;
+			verify_test(bp.IsValid(comm, oracle, bch));
+		}
+
+		const size_t nProofSize = sizeof(MultiMac::Casual) * InnerProduct::BatchContext::s_CasualCountPerProof;
+		verify_test(bch.get_BufSize() == nProofSize * 3);
+		verify_test(bch.Flush());
+
+		// the big batch was within the trim period, the buffer is kept
+		for (uint32_t i = 0; i < InnerProduct::BatchContextHeap::s_TrimPeriod; i++)
+			bch.Trim();
+		verify_test(bch.get_BufSize() == nProofSize * 3);
+
+		// small batches during the whole period, the buffer shrinks back
+		for (uint32_t i = 0; i < InnerProduct::BatchContextHeap::s_TrimPeriod; i++)
+			bch.Trim();
+		verify_test(bch.get_BufSize() == nProofSize);
+
+		Oracle oracle;
+		verify_test(bp.IsValid(comm, oracle, bch));
+		verify_test(bch.Flush());
+	}
+
+	{
+		// parallel evaluation of the batch
+		const uint32_t nCasualPerThreadMin = InnerProduct::BatchContext::s_CasualPerThreadMin;
+		InnerProduct::BatchContext::s_CasualPerThreadMin = 1;
+		bc.m_nThreads = 3;
+
+		for (int iTamper = 0; iTamper < 2; iTamper++)
+		{
+			for (int i = 0; i < 2; i++)
+			{
+				Oracle oracle;
+				verify_test(bp.IsValid(comm, oracle, bc));
+			}
+
+			if (iTamper)
+				bc.AddPrepared(InnerProduct::BatchContext::s_Idx_G, sk);
+
+			verify_test(bc.Flush() == !iTamper);
+			bc.Reset();
+		}
+
+		bc.m_nThreads = 1;
+		InnerProduct::BatchContext::s_CasualPerThreadMin = nCasualPerThreadMin;
+	}
+
 
 	WriteSizeSerialized("BulletProof", bp);
 
@@ -1223,6 +1462,7 @@ struct BenchmarkMeter
 
 	uint64_t m_Start;
 	uint64_t m_Cycles;
+	double m_us; // per cycle, when done
 
 	uint32_t N;
 
@@ -1253,6 +1493,7 @@ struct BenchmarkMeter
 	BenchmarkMeter(const char* sz)
 		:m_sz(sz)
 		,m_Cycles(0)
+		,m_us(0)
 		,N(1000)
 	{
 #ifdef WIN32
@@ -1269,7 +1510,8 @@ struct BenchmarkMeter
 		double dt_s = double(get_Time() - m_Start) / double(m_Freq);
 		if (dt_s >= 1.)
 		{
-			printf("%-24s: %.2f us\n", m_sz, dt_s * 1e6 / double(m_Cycles));
+			m_us = dt_s * 1e6 / double(m_Cycles);
+			printf("%-24s: %.2f us\n", m_sz, m_us);
 			return false;
 		}
 
@@ -1280,6 +1522,84 @@ struct BenchmarkMeter
 	}
 };
 
+template <int nCount>
+void RunBenchmarkMultiMac(bool bBuckets)
+{
+	// casual points only, per-point cost
+	typedef MultiMac_WithBufs<nCount, 1> MyMultiMac;
+	std::unique_ptr<MyMultiMac> pMm(new MyMultiMac);
+
+	Scalar::Native k;
+	k = 1U;
+	Point::Native g = Context::get().G * k;
+
+	std::vector<Point::Native> vPts(nCount);
+	std::vector<Scalar::Native> vK(nCount);
+	for (int i = 0; i < nCount; i++)
+	{
+		SetRandom(vK[i]);
+		vPts[i] = g * vK[i];
+		SetRandom(vK[i]);
+	}
+
+	const uint32_t nBucketsMin = MultiMac::s_BucketsMin;
+	MultiMac::s_BucketsMin = bBuckets ? 0 : uint32_t(-1);
+
+	char sz[0x40];
+	snprintf(sz, sizeof(sz), "MultiMac.%s-%d", bBuckets ? "Buckets" : "Odd", nCount);
+
+	Point::Native res;
+	{
+		BenchmarkMeter bm(sz);
+		bm.N = nCount;
+		do
+		{
+			for (uint32_t i = 0; i < bm.N; i += nCount)
+			{
+				pMm->Reset();
+				for (int j = 0; j < nCount; j++)
+					pMm->m_pCasual[pMm->m_Casual++].Init(vPts[j], vK[j]);
+
+				pMm->Calculate(res);
+			}
+
+		} while (bm.ShouldContinue());
+	}
+
+	MultiMac::s_BucketsMin = nBucketsMin;
+}
+
+void RunBenchmarkBulletProofBatch(const RangeProof::Confidential& bp, const Point::Native& comm, uint32_t nBatch, uint32_t nBatchInitial)
+{
+	// per-proof cost and throughput, depending on the batch size. The heap batch grows from the initial size on demand
+	InnerProduct::BatchContextHeap bc(nBatchInitial, nBatch);
+	bc.m_bEnableBatch = true;
+
+	InnerProduct::BatchContext::Scope scope(bc);
+
+	char sz[0x40];
+	snprintf(sz, sizeof(sz), "BulletProof.Verify/%u%s", nBatch, (nBatchInitial < nBatch) ? "+" : "");
+
+	BenchmarkMeter bm(sz);
+	bm.N = nBatch;
+	do
+	{
+		for (uint32_t i = 0; i < bm.N; i += nBatch)
+		{
+			for (uint32_t n = 0; n < nBatch; n++)
+			{
+				Oracle oracle;
+				bp.IsValid(comm, oracle);
+			}
+
+			verify_test(bc.Flush());
+		}
+
+	} while (bm.ShouldContinue());
+
+	printf("%-24s  %.0f proofs/s, batch buffer %u KB\n", "", 1e6 / bm.m_us, static_cast<uint32_t>(bc.get_BufSize() >> 10));
+}
+
 void RunBenchmark()
 {
 	Scalar::Native k1, k2;
@@ -1471,6 +1791,20 @@ void RunBenchmark()
 		} while (bm.ShouldContinue());
 	}
 
+	{
+		PointCache pc;
+		pc.Resize(1024 * 1024);
+		pc.Import(p0, p_, true);
+
+		BenchmarkMeter bm("point.Import.Cached");
+		do
+		{
+			for (uint32_t i = 0; i < bm.N; i++)
+				pc.Import(p0, p_, false);
+
+		} while (bm.ShouldContinue());
+	}
+
 	{
 		BenchmarkMeter bm("H.Multiply");
 		do
@@ -1553,6 +1887,29 @@ void RunBenchmark()
 		} while (bm.ShouldContinue());
 	}
 
+	{
+		BenchmarkMeter bm("signature.Verify x100");
+		bm.N = 10;
+
+		typedef InnerProduct::BatchContextEx<100> MyBatch;
+		std::unique_ptr<MyBatch> p(new MyBatch);
+		p->m_bEnableBatch = true;
+
+		InnerProduct::BatchContext::Scope scope(*p);
+
+		do
+		{
+			for (uint32_t i = 0; i < bm.N; i++)
+			{
+				for (int n = 0; n < 100; n++)
+					sig.IsValid(hv, p1);
+
+				verify_test(p->Flush());
+			}
+
+		} while (bm.ShouldContinue());
+	}
+
 	Scalar::Native pA[InnerProduct::nDim];
 	Scalar::Native pB[InnerProduct::nDim];
 
@@ -1652,6 +2009,26 @@ void RunBenchmark()
 		} while (bm.ShouldContinue());
 	}
 
+	{
+		Mode::Scope scope(Mode::Fast);
+
+		RunBenchmarkMultiMac<64>(false);
+		RunBenchmarkMultiMac<64>(true);
+		RunBenchmarkMultiMac<128>(false);
+		RunBenchmarkMultiMac<128>(true);
+		RunBenchmarkMultiMac<256>(false);
+		RunBenchmarkMultiMac<256>(true);
+		RunBenchmarkMultiMac<512>(false);
+		RunBenchmarkMultiMac<512>(true);
+		RunBenchmarkMultiMac<2048>(false);
+		RunBenchmarkMultiMac<2048>(true);
+	}
+
+	for (uint32_t nBatch = 1; nBatch <= 800; nBatch <<= 1)
+		RunBenchmarkBulletProofBatch(bp, comm, nBatch, nBatch);
+
+	RunBenchmarkBulletProofBatch(bp, comm, 400, 8); // adaptive, grows on demand
+
 	{
 		AES::Encoder enc;
 		enc.Init(hv.m_pData);
@@ -1686,6 +2063,62 @@ void RunBenchmark()
 		} while (bm.ShouldContinue());
 	}
 
+	{
+		// UTXO tree rehash after a block-sized batch of modifications: serial vs parallel
+		beam::UtxoTree t;
+		std::vector<beam::UtxoTree::Key> vKeys(200000);
+
+		for (size_t i = 0; i < vKeys.size(); i++)
+		{
+			GenRandom(vKeys[i].m_pArr, sizeof(vKeys[i].m_pArr));
+
+			beam::UtxoTree::Cursor cu;
+			bool bCreate = true;
+			t.Find(cu, vKeys[i], bCreate)->m_Value.m_Count = 1;
+		}
+
+		t.get_Hash(hv);
+
+		const uint32_t nThreads = std::max(2U, std::thread::hardware_concurrency());
+
+		for (uint32_t iPass = 0; iPass < 2; iPass++)
+		{
+			BenchmarkMeter bm(iPass ? "Utxo.Rehash-1K.MT" : "Utxo.Rehash-1K");
+			bm.N = 1;
+			do
+			{
+				for (uint32_t i = 0; i < bm.N; i++)
+				{
+					for (uint32_t j = 0; j < 1000; j++)
+					{
+						beam::UtxoTree::Cursor cu;
+						bool bCreate = false;
+						beam::UtxoTree::MyLeaf* p = t.Find(cu, vKeys[rand() % vKeys.size()], bCreate);
+
+						cu.InvalidateElement();
+						p->m_Value.m_Count++;
+					}
+
+					if (iPass)
+					{
+						beam::UtxoTree::DirtyList vDirty;
+						t.get_DirtySubtrees(vDirty, nThreads * 8);
+
+						std::vector<std::thread> vThreads(nThreads);
+						for (uint32_t iThread = 0; iThread < nThreads; iThread++)
+							vThreads[iThread] = std::thread(&beam::UtxoTree::HashDirty, &t, std::cref(vDirty), iThread, nThreads);
+
+						for (uint32_t iThread = 0; iThread < nThreads; iThread++)
+							vThreads[iThread].join();
+					}
+
+					t.get_Hash(hv);
+				}
+
+			} while (bm.ShouldContinue());
+		}
+	}
+
 
 	{
 		secp256k1_pedersen_commitment comm2;
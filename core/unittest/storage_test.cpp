@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <iostream>
+#include <thread>
 #include "../radixtree.h"
 #include "../navigator.h"
 #include "../../utility/serialize.h"
@@ -265,6 +266,9 @@ namespace beam
 
 		t.get_Hash(hv1);
 
+		size_t nMem = t.get_MemoryUsage();
+		verify_test(nMem >= vKeys.size() * sizeof(UtxoTree::MyLeaf));
+
 		for (uint32_t i = 0; i < vKeys.size(); i++)
 		{
 			if (i == vKeys.size()/2)
@@ -311,6 +315,7 @@ namespace beam
 		verify_test(hv2 == hv1);
 
 		verify_test(vKeys.size() == t.Count());
+		verify_test(t.get_MemoryUsage() == nMem); // freed nodes must be reused
 
 		// serialization
 		Serializer ser;
@@ -355,6 +360,186 @@ namespace beam
 		t2.m_pBound[0] = t2.m_Min.m_pArr;
 		t2.m_pBound[1] = t2.m_Max.m_pArr;
 		t.Traverse(t2);
+
+		// parallel rehash must give the same result as the serial one
+		{
+			UtxoTree t3;
+			der.reset(sb.first, sb.second);
+			t3.load(der);
+
+			std::vector<UtxoTree::Key> vNew(1000);
+			for (size_t i = 0; i < vNew.size(); i++)
+			{
+				UtxoTree::Key::Data d;
+				SetRandomUtxoKey(d);
+				vNew[i] = d;
+			}
+
+			UtxoTree* ppT[] = { &t, &t3 };
+			for (size_t iT = 0; iT < _countof(ppT); iT++)
+			{
+				UtxoTree& tt = *ppT[iT];
+
+				for (uint32_t i = 0; i < vKeys.size(); i += 7)
+				{
+					UtxoTree::Cursor cu;
+					bool bCreate = false;
+					UtxoTree::MyLeaf* p = tt.Find(cu, vKeys[i], bCreate);
+					verify_test(p);
+
+					if (i % 3)
+					{
+						cu.InvalidateElement();
+						p->m_Value.m_Count++;
+					}
+					else
+						tt.Delete(cu);
+				}
+
+				for (size_t i = 0; i < vNew.size(); i++)
+				{
+					UtxoTree::Cursor cu;
+					bool bCreate = true;
+					tt.Find(cu, vNew[i], bCreate)->m_Value.m_Count = 1;
+				}
+			}
+
+			t.get_Hash(hv1);
+
+			const uint32_t nThreads = 4;
+			UtxoTree::DirtyList vDirty;
+			t3.get_DirtySubtrees(vDirty, nThreads * 8);
+			verify_test(vDirty.size() >= nThreads * 8);
+
+			std::thread pThreads[nThreads];
+			for (uint32_t i = 0; i < nThreads; i++)
+				pThreads[i] = std::thread(&UtxoTree::HashDirty, &t3, std::cref(vDirty), i, nThreads);
+			for (uint32_t i = 0; i < nThreads; i++)
+				pThreads[i].join();
+
+			t3.get_Hash(hv2);
+			verify_test(hv1 == hv2);
+		}
+
+		t.Clear();
+		verify_test(!t.get_MemoryUsage());
+	}
+
+	void TestUtxoTreeCompact()
+	{
+		std::vector<UtxoTree::Key> vKeys;
+		vKeys.resize(20000);
+
+		UtxoTree t0;
+		UtxoTreeCompact t1;
+		Merkle::Hash hv0, hv1;
+
+		for (uint32_t i = 0; i < vKeys.size(); i++)
+		{
+			UtxoTree::Key::Data d;
+			SetRandomUtxoKey(d);
+
+			if (i & 1)
+				memcpy(d.m_Commitment.m_X.m_pData, vKeys[i - 1].m_pArr, d.m_Commitment.m_X.nBytes); // shares the X with the prev key
+			vKeys[i] = d;
+
+			UtxoTree::Cursor cu0;
+			UtxoTreeCompact::Cursor cu1;
+			bool bCreate = true;
+			t0.Find(cu0, vKeys[i], bCreate)->m_Value.m_Count = i;
+
+			bCreate = true;
+			UtxoTreeCompact::MyLeaf* p = t1.Find(cu1, vKeys[i], bCreate);
+			verify_test(p && bCreate);
+			p->m_Value.m_Count = i;
+
+			if (!(i % 13))
+			{
+				t0.get_Hash(hv0);
+				t1.get_Hash(hv1);
+				verify_test(hv0 == hv1);
+
+				uint32_t j = rand() % (i + 1);
+				bCreate = false;
+				p = t1.Find(cu1, vKeys[j], bCreate);
+				verify_test(p && !bCreate && (p->m_Value.m_Count == j));
+
+				Merkle::Proof proof;
+				t1.get_Proof(proof, cu1);
+
+				p->m_Value.get_Hash(hv1, p->m_Key);
+				Merkle::Interpret(hv1, proof);
+				verify_test(hv0 == hv1);
+			}
+		}
+
+		verify_test(t1.Count() == vKeys.size());
+
+		// traverse, with and without bounds
+		struct Traveler
+			:public UtxoTreeCompact::ITraveler
+		{
+			UtxoTree::Key m_Last;
+			size_t m_Count;
+
+			virtual bool OnLeaf(const UtxoTreeCompact::MyLeaf& x) override
+			{
+				if (m_Count)
+					verify_test(x.m_Key > m_Last);
+				if (m_pBound[0])
+					verify_test(x.m_Key >= *m_pBound[0]);
+				if (m_pBound[1])
+					verify_test(x.m_Key <= *m_pBound[1]);
+
+				m_Last = x.m_Key;
+				m_Count++;
+				return true;
+			}
+		} t2;
+
+		t2.m_Count = 0;
+		t1.Traverse(t2);
+		verify_test(t2.m_Count == vKeys.size());
+
+		UtxoTree::Key kMin = vKeys[7], kMax = vKeys[8];
+		if (kMax < kMin)
+			std::swap(kMin, kMax);
+
+		t2.m_Count = 0;
+		t2.m_pBound[0] = &kMin;
+		t2.m_pBound[1] = &kMax;
+		t1.Traverse(t2);
+
+		size_t nInRange = 0;
+		for (size_t i = 0; i < vKeys.size(); i++)
+			if ((vKeys[i] >= kMin) && (vKeys[i] <= kMax))
+				nInRange++;
+		verify_test(t2.m_Count == nInRange);
+
+		// delete
+		for (uint32_t i = 0; i < vKeys.size(); i++)
+		{
+			UtxoTree::Cursor cu0;
+			UtxoTreeCompact::Cursor cu1;
+			bool bCreate = false;
+
+			verify_test(t0.Find(cu0, vKeys[i], bCreate));
+			t0.Delete(cu0);
+
+			verify_test(t1.Find(cu1, vKeys[i], bCreate));
+			t1.Delete(cu1);
+
+			if (!(i % 17))
+			{
+				t0.get_Hash(hv0);
+				t1.get_Hash(hv1);
+				verify_test(hv0 == hv1);
+			}
+		}
+
+		t1.get_Hash(hv1);
+		verify_test(hv1 == Zero);
+		verify_test(!t1.Count());
 	}
 
 	struct MyMmr
@@ -593,6 +778,7 @@ int main()
 {
 	beam::TestNavigator();
 	beam::TestUtxoTree();
+	beam::TestUtxoTreeCompact();
 	beam::TestMmr();
 
 	return g_TestsFailed ? -1 : 0;
@@ -20,6 +20,8 @@
 #include "nlohmann/json.hpp"
 #include "utility/helpers.h"
 #include "utility/logger.h"
+#include <mutex>
+#include <optional>
 
 namespace beam { namespace explorer {
 
@@ -53,6 +55,9 @@ struct ResponseCache {
     Height currentHeight=0;
     Height lowHorizon=0;
 
+    // blocks and heights are shared with the concurrent readers
+    std::mutex mutex;
+
     explicit ResponseCache(size_t depth) : _depth(depth)
     {}
 
@@ -67,6 +72,7 @@ struct ResponseCache {
         auto it = b;
         while (it != blocks.end()) {
             if (it->first >= horizon) break;
+            ++it;
         }
         blocks.erase(b, it);
     }
@@ -90,29 +96,76 @@ private:
 
 using nlohmann::json;
 
-} //namespace
-
-/// Explorer server backend, gets callback on status update and returns json messages for server
-class Adapter : public INodeObserver, public IAdapter {
+/// Extracts blocks from the node db, either the main connection (node thread only) or its own read-only one
+class BlockReader : public IBlockReader {
 public:
-    Adapter(Node& node) :
-        _packer(PACKER_FRAGMENTS_SIZE),
-        _nodeBackend(node.get_Processor()),
-        _statusDirty(true),
-        _nodeIsSyncing(true),
-        _cache(CACHE_DEPTH)
+    BlockReader(NodeDB& db, ResponseCache& cache) :
+        _db(db),
+        _cache(cache),
+        _packer(PACKER_FRAGMENTS_SIZE)
     {
         init_helper_fragments();
-        _hook = &node.m_Cfg.m_Observer;
-        _nextHook = *_hook;
-        *_hook = this;
     }
 
-    virtual ~Adapter() {
-        if (_nextHook) *_hook = _nextHook;
+    BlockReader(std::unique_ptr<NodeDB>&& db, ResponseCache& cache) :
+        BlockReader(*db, cache)
+    {
+        _ownDB = std::move(db);
+    }
+
+    bool get_block(io::SerializedMsg& out, uint64_t height) override {
+        return with_snapshot(out, [&]() {
+            uint64_t row=0;
+            return get_block_impl(out, height, row, 0);
+        });
+    }
+
+    bool get_blocks(io::SerializedMsg& out, uint64_t startHeight, uint64_t n) override {
+        // all the blocks from the same state, while the node may proceed
+        return with_snapshot(out, [&]() {
+            return get_blocks_impl(out, startHeight, n);
+        });
     }
 
 private:
+    template <typename Func>
+    bool with_snapshot(io::SerializedMsg& out, Func&& func) {
+        // the node may delete a block store segment after the snapshot is taken, before it's read. Then retry once with a new snapshot
+        size_t outSize = out.size();
+        for (int attempt = 0; ; ++attempt) {
+            try {
+                std::optional<NodeDB::Snapshot> snapshot;
+                if (_ownDB) snapshot.emplace(_db);
+                return func();
+            } catch (const BlockStore::SegmentMissing&) {
+                if (attempt || !_ownDB) throw;
+                out.resize(outSize);
+            }
+        }
+    }
+
+    bool get_blocks_impl(io::SerializedMsg& out, uint64_t startHeight, uint64_t n) {
+        static const uint64_t maxElements = 100;
+        if (n > maxElements) n = maxElements;
+        else if (n==0) n=1;
+        Height endHeight = startHeight + n - 1;
+        out.push_back(_leftBrace);
+        uint64_t row = 0;
+        uint64_t prevRow = 0;
+        for (;;) {
+            bool ok = get_block_impl(out, endHeight, row, &prevRow);
+            if (!ok) return false;
+            if (endHeight == startHeight) {
+                break;
+            }
+            out.push_back(_comma);
+            row = prevRow;
+            --endHeight;
+        }
+        out.push_back(_rightBrace);
+        return true;
+    }
+
     void init_helper_fragments() {
         static const char* s = "[,]";
         io::SharedBuffer buf(s, 3);
@@ -126,72 +179,21 @@ private:
         _rightBrace.data += 2;
     }
 
-    /// Returns body for /status request
-    void OnSyncProgress(int done, int total) override {
-        bool isSyncing = (done != total);
-        if (isSyncing != _nodeIsSyncing) {
-            _statusDirty = true;
-            _nodeIsSyncing = isSyncing;
-        }
-        if (_nextHook) _nextHook->OnSyncProgress(done, total);
-    }
-
-    void OnStateChanged() override {
-        const auto& cursor = _nodeBackend.m_Cursor;
-        _cache.currentHeight = cursor.m_ID.m_Height;
-        _cache.lowHorizon = cursor.m_LoHorizon;
-        _statusDirty = true;
-        if (_nextHook) _nextHook->OnStateChanged();
-    }
-
-    bool get_status(io::SerializedMsg& out) override {
-        if (_statusDirty) {
-            const auto& cursor = _nodeBackend.m_Cursor;
-
-            _cache.currentHeight = cursor.m_Sid.m_Height;
-            _cache.lowHorizon = cursor.m_LoHorizon;
-
-            char buf[80];
-
-            _sm.clear();
-            if (!serialize_json_msg(
-                _sm,
-                _packer,
-                json{
-                    { "timestamp", cursor.m_Full.m_TimeStamp },
-                    { "height", _cache.currentHeight },
-                    { "low_horizon", cursor.m_LoHorizon },
-                    { "hash", hash_to_hex(buf, cursor.m_ID.m_Hash) },
-                    { "chainwork",  uint256_to_hex(buf, cursor.m_Full.m_ChainWork) }
-                }
-            )) {
-                return false;
-            }
-
-            _cache.status = io::normalize(_sm, false);
-            _statusDirty = false;
-            _sm.clear();
-        }
-        out.push_back(_cache.status);
-        return true;
-    }
-
     bool extract_row(Height height, uint64_t& row, uint64_t* prevRow) {
-        NodeDB& db = _nodeBackend.get_DB();
-        NodeDB::WalkerState ws(db);
-        db.EnumStatesAt(ws, height);
+        NodeDB::WalkerState ws(_db);
+        _db.EnumStatesAt(ws, height);
         while (true) {
             if (!ws.MoveNext()) {
                 return false;
             }
-            if (NodeDB::StateFlags::Active & db.GetStateFlags(ws.m_Sid.m_Row)) {
+            if (NodeDB::StateFlags::Active & _db.GetStateFlags(ws.m_Sid.m_Row)) {
                 row = ws.m_Sid.m_Row;
                 break;
             }
         }
         if (prevRow) {
             *prevRow = row;
-            if (!db.get_Prev(*prevRow)) {
+            if (!_db.get_Prev(*prevRow)) {
                 *prevRow = 0;
             }
         }
@@ -199,12 +201,10 @@ private:
     }
 
     bool extract_block_from_row(json& out, uint64_t row) {
-        NodeDB& db = _nodeBackend.get_DB();
-
         Block::SystemState::Full blockState;
         bool ok = true;
         try {
-            db.get_State(row, blockState);
+            _db.get_State(row, blockState);
         } catch (...) {
             ok = false;
         }
@@ -216,7 +216,7 @@ private:
         ByteBuffer bbP, bbE;
         if (ok) {
             ByteBuffer rollbackBuf;
-            db.GetStateBlock(row, &bbP, &bbE, &rollbackBuf);
+            _db.GetStateBlock(row, &bbP, &bbE, &rollbackBuf);
             if (bbP.empty()) {
                 ok = false;
             }
@@ -294,7 +294,7 @@ private:
             ok = extract_row(height, row, prevRow);
         } else if (prevRow != 0) {
             *prevRow = row;
-            if (!_nodeBackend.get_DB().get_Prev(*prevRow)) {
+            if (!_db.get_Prev(*prevRow)) {
                 *prevRow = 0;
             }
         }
@@ -302,7 +302,16 @@ private:
     }
 
     bool get_block_impl(io::SerializedMsg& out, uint64_t height, uint64_t& row, uint64_t* prevRow) {
-        if (_cache.get_block(out, height)) {
+        Height currentHeight = 0;
+        bool cached = false;
+        {
+            // no DB access under the lock, the node thread takes it on each state change
+            std::lock_guard<std::mutex> lock(_cache.mutex);
+            cached = _cache.get_block(out, height);
+            currentHeight = _cache.currentHeight;
+        }
+
+        if (cached) {
             if (prevRow && row > 0) {
                 extract_row(height, row, prevRow);
             }
@@ -310,7 +319,7 @@ private:
         }
 
         io::SharedBuffer body;
-        bool blockAvailable = (/*height >= _cache.lowHorizon && */height <= _cache.currentHeight);
+        bool blockAvailable = (/*height >= _cache.lowHorizon && */height <= currentHeight);
         if (blockAvailable) {
             json j;
             if (!extract_block(j, height, row, prevRow)) {
@@ -319,6 +328,7 @@ private:
                 _sm.clear();
                 if (serialize_json_msg(_sm, _packer, j)) {
                     body = io::normalize(_sm, false);
+                    std::lock_guard<std::mutex> lock(_cache.mutex);
                     _cache.put_block(height, body);
                 } else {
                     return false;
@@ -335,41 +345,120 @@ private:
         return serialize_json_msg(out, _packer, json{ { "found", false}, {"height", height } });
     }
 
-    bool get_block(io::SerializedMsg& out, uint64_t height) override {
-        uint64_t row=0;
-        return get_block_impl(out, height, row, 0);
+    std::unique_ptr<NodeDB> _ownDB; // set for the concurrent reader
+    NodeDB& _db;
+
+    ResponseCache& _cache;
+
+    HttpMsgCreator _packer;
+
+    // helper fragments
+    io::SharedBuffer _leftBrace, _comma, _rightBrace;
+
+    io::SerializedMsg _sm;
+};
+
+} //namespace
+
+/// Explorer server backend, gets callback on status update and returns json messages for server
+class Adapter : public INodeObserver, public IAdapter {
+public:
+    Adapter(Node& node) :
+        _packer(PACKER_FRAGMENTS_SIZE),
+        _node(node),
+        _nodeBackend(node.get_Processor()),
+        _statusDirty(true),
+        _nodeIsSyncing(true),
+        _cache(CACHE_DEPTH),
+        _reader(_nodeBackend.get_DB(), _cache)
+    {
+        _hook = &node.m_Cfg.m_Observer;
+        _nextHook = *_hook;
+        *_hook = this;
     }
 
-    bool get_blocks(io::SerializedMsg& out, uint64_t startHeight, uint64_t n) override {
-        static const uint64_t maxElements = 100;
-        if (n > maxElements) n = maxElements;
-        else if (n==0) n=1;
-        Height endHeight = startHeight + n - 1;
-        out.push_back(_leftBrace);
-        uint64_t row = 0;
-        uint64_t prevRow = 0;
-        for (;;) {
-            bool ok = get_block_impl(out, endHeight, row, &prevRow);
-            if (!ok) return false;
-            if (endHeight == startHeight) {
-                break;
+    virtual ~Adapter() {
+        if (_nextHook) *_hook = _nextHook;
+    }
+
+private:
+    /// Returns body for /status request
+    void OnSyncProgress(int done, int total) override {
+        bool isSyncing = (done != total);
+        if (isSyncing != _nodeIsSyncing) {
+            _statusDirty = true;
+            _nodeIsSyncing = isSyncing;
+        }
+        if (_nextHook) _nextHook->OnSyncProgress(done, total);
+    }
+
+    void OnStateChanged() override {
+        const auto& cursor = _nodeBackend.m_Cursor;
+        {
+            std::lock_guard<std::mutex> lock(_cache.mutex);
+            _cache.currentHeight = cursor.m_ID.m_Height;
+            _cache.lowHorizon = cursor.m_LoHorizon;
+        }
+        _statusDirty = true;
+        if (_nextHook) _nextHook->OnStateChanged();
+    }
+
+    IBlockReader::Ptr create_reader() override {
+        std::unique_ptr<NodeDB> db(new NodeDB);
+        _node.OpenReadOnly(*db);
+        return IBlockReader::Ptr(new BlockReader(std::move(db), _cache));
+    }
+
+    bool get_status(io::SerializedMsg& out) override {
+        if (_statusDirty) {
+            const auto& cursor = _nodeBackend.m_Cursor;
+
+            {
+                std::lock_guard<std::mutex> lock(_cache.mutex);
+                _cache.currentHeight = cursor.m_Sid.m_Height;
+                _cache.lowHorizon = cursor.m_LoHorizon;
             }
-            out.push_back(_comma);
-            row = prevRow;
-            --endHeight;
+
+            char buf[80];
+
+            _sm.clear();
+            if (!serialize_json_msg(
+                _sm,
+                _packer,
+                json{
+                    { "timestamp", cursor.m_Full.m_TimeStamp },
+                    { "height", cursor.m_Sid.m_Height },
+                    { "low_horizon", cursor.m_LoHorizon },
+                    { "hash", hash_to_hex(buf, cursor.m_ID.m_Hash) },
+                    { "chainwork",  uint256_to_hex(buf, cursor.m_Full.m_ChainWork) }
+                }
+            )) {
+                return false;
+            }
+
+            _cache.status = io::normalize(_sm, false);
+            _statusDirty = false;
+            _sm.clear();
         }
-        out.push_back(_rightBrace);
+        out.push_back(_cache.status);
         return true;
     }
 
+    bool get_block(io::SerializedMsg& out, uint64_t height) override {
+        return _reader.get_block(out, height);
+    }
+
+    bool get_blocks(io::SerializedMsg& out, uint64_t startHeight, uint64_t n) override {
+        return _reader.get_blocks(out, startHeight, n);
+    }
+
     HttpMsgCreator _packer;
 
+    Node& _node;
+
     // node db interface
     NodeProcessor& _nodeBackend;
 
-    // helper fragments
-    io::SharedBuffer _leftBrace, _comma, _rightBrace;
-
     // If true then status boby needs to be refreshed
     bool _statusDirty;
 
@@ -382,6 +471,9 @@ private:
 
     ResponseCache _cache;
 
+    // on the main node db connection, used within the node thread
+    BlockReader _reader;
+
     io::SerializedMsg _sm;
 };
 
@@ -20,12 +20,27 @@ struct Node;
 
 namespace explorer {
 
+/// Block data reader, not thread-safe. Each worker thread owns one
+struct IBlockReader {
+    using Ptr = std::unique_ptr<IBlockReader>;
+
+    virtual ~IBlockReader() = default;
+
+    virtual bool get_block(io::SerializedMsg& out, uint64_t height) = 0;
+
+    virtual bool get_blocks(io::SerializedMsg& out, uint64_t startHeight, uint64_t n) = 0;
+};
+
 /// node->explorer adapter interface
 struct IAdapter {
     using Ptr = std::unique_ptr<IAdapter>;
 
     virtual ~IAdapter() = default;
 
+    /// Creates a reader on a separate read-only DB connection, may be used concurrently with the node thread.
+    /// Must be called after the node is initialized
+    virtual IBlockReader::Ptr create_reader() = 0;
+
     /// Returns body for /status request
     virtual bool get_status(io::SerializedMsg& out) = 0;
 
@@ -13,6 +13,7 @@ namespace po = boost::program_options;
 #define PEER_PARAMETER "peer"
 #define PORT_PARAMETER "port"
 #define API_PORT_PARAMETER "api_port"
+#define API_WORKERS_PARAMETER "api_workers"
 #define HELP_FULL_PARAMETER "help,h"
 #define HELP_PARAMETER "help"
 
@@ -22,6 +23,7 @@ struct Options {
     std::string nodeConnectTo;
     io::Address nodeListenTo;
     io::Address explorerListenTo;
+    unsigned explorerWorkers;
     int logLevel;
     static const unsigned logRotationPeriod = 3*60*60*1000; // 3 hours
 };
@@ -48,7 +50,7 @@ int main(int argc, char* argv[]) {
         setup_node(node, options);
         explorer::IAdapter::Ptr adapter = explorer::create_adapter(node);
         node.Initialize();
-        explorer::Server server(*adapter, *reactor, options.explorerListenTo, options.accessControlFile);
+        explorer::Server server(*adapter, *reactor, options.explorerListenTo, options.accessControlFile, options.explorerWorkers);
         LOG_INFO() << "Node listens to " << options.nodeListenTo << ", explorer listens to " << options.explorerListenTo;
         reactor->run();
         LOG_INFO() << "Done";
@@ -69,7 +71,8 @@ bool parse_cmdline(int argc, char* argv[], Options& o) {
         (HELP_FULL_PARAMETER, "list of all options")
         (PEER_PARAMETER, po::value<string>()->default_value("172.104.249.212:8101"), "peer address")
         (PORT_PARAMETER, po::value<uint16_t>()->default_value(10000), "port to start the local node on")
-        (API_PORT_PARAMETER, po::value<uint16_t>()->default_value(8888), "port to start the local api server on");
+        (API_PORT_PARAMETER, po::value<uint16_t>()->default_value(8888), "port to start the local api server on")
+        (API_WORKERS_PARAMETER, po::value<unsigned>()->default_value(2), "number of threads serving blocks to the api clients, 0 - serve within the node thread");
         
 #ifdef NDEBUG
     o.logLevel = LOG_LEVEL_INFO;
@@ -97,6 +100,7 @@ bool parse_cmdline(int argc, char* argv[], Options& o) {
         o.nodeConnectTo = vm[PEER_PARAMETER].as<string>();
         o.nodeListenTo.port(vm[PORT_PARAMETER].as<uint16_t>());
         o.explorerListenTo.port(vm[API_PORT_PARAMETER].as<uint16_t>());
+        o.explorerWorkers = vm[API_WORKERS_PARAMETER].as<unsigned>();
 
         return true;
     }
@@ -37,7 +37,7 @@ enum Dirs {
 
 } //namespace
 
-Server::Server(IAdapter& adapter, io::Reactor& reactor, io::Address bindAddress, const std::string& keysFileName) :
+Server::Server(IAdapter& adapter, io::Reactor& reactor, io::Address bindAddress, const std::string& keysFileName, unsigned numWorkers) :
     _msgCreator(2000),
     _backend(adapter),
     _reactor(reactor),
@@ -47,6 +47,115 @@ Server::Server(IAdapter& adapter, io::Reactor& reactor, io::Address bindAddress,
 {
     _timers.set_timer(SERVER_RESTART_TIMER, 0, BIND_THIS_MEMFN(start_server));
     _timers.set_timer(ACL_REFRESH_TIMER, ACL_REFRESH_INTERVAL, BIND_THIS_MEMFN(refresh_acl));
+
+    if (numWorkers) {
+        start_workers(numWorkers);
+    }
+}
+
+Server::~Server() {
+    stop_workers();
+}
+
+void Server::start_workers(unsigned numWorkers) {
+    _jobsDoneEvent = io::AsyncEvent::create(_reactor, BIND_THIS_MEMFN(on_jobs_done));
+
+    for (unsigned i=0; i<numWorkers; ++i) {
+        _readers.push_back(_backend.create_reader());
+    }
+    for (auto& r : _readers) {
+        IBlockReader& reader = *r;
+        _workers.emplace_back([this, &reader]() { worker_thread(reader); });
+    }
+    LOG_INFO() << STS << numWorkers << " worker threads";
+}
+
+void Server::stop_workers() {
+    {
+        std::lock_guard<std::mutex> lock(_jobsMutex);
+        _stopWorkers = true;
+    }
+    _jobsCond.notify_all();
+
+    for (auto& t : _workers) {
+        t.join();
+    }
+    _workers.clear();
+    _readers.clear();
+}
+
+void Server::worker_thread(IBlockReader& reader) {
+    std::unique_lock<std::mutex> lock(_jobsMutex);
+    for (;;) {
+        if (_stopWorkers) break;
+        if (_jobsPending.empty()) {
+            _jobsCond.wait(lock);
+            continue;
+        }
+
+        Job job = std::move(_jobsPending.front());
+        _jobsPending.pop_front();
+        lock.unlock();
+
+        try {
+            job.ok = (job.dir == DIR_BLOCK) ?
+                reader.get_block(job.body, job.height) :
+                reader.get_blocks(job.body, job.height, job.n);
+        } catch (const std::exception& e) {
+            LOG_ERROR() << STS << e.what();
+            job.body.clear();
+            job.ok = false;
+        }
+
+        lock.lock();
+        _jobsDone.push_back(std::move(job));
+        _jobsDoneEvent->post();
+    }
+}
+
+bool Server::post_job(const HttpConnection::Ptr& conn, int dir, uint64_t height, uint64_t n) {
+    Job job;
+    job.connId = conn->id();
+    job.dir = dir;
+    job.height = height;
+    job.n = n;
+    job.ok = false;
+
+    _busyConnections.insert(job.connId);
+    {
+        std::lock_guard<std::mutex> lock(_jobsMutex);
+        _jobsPending.push_back(std::move(job));
+    }
+    _jobsCond.notify_one();
+
+    return true; // the response is sent once done
+}
+
+void Server::on_jobs_done() {
+    std::deque<Job> done;
+    {
+        std::lock_guard<std::mutex> lock(_jobsMutex);
+        done.swap(_jobsDone);
+    }
+
+    for (auto& job : done) {
+        _busyConnections.erase(job.connId);
+
+        auto it = _connections.find(job.connId);
+        if (it == _connections.end()) continue; // gone in the meanwhile
+
+        const HttpConnection::Ptr& conn = it->second;
+        _body = std::move(job.body);
+
+        bool keepalive = job.ok ?
+            send(conn, 200, "OK") :
+            send(conn, 500, (job.dir == DIR_BLOCK) ? "Internal error #2" : "Internal error #3");
+
+        if (!keepalive) {
+            conn->shutdown();
+            _connections.erase(it);
+        }
+    }
 }
 
 void Server::start_server() {
@@ -97,6 +206,14 @@ bool Server::on_request(uint64_t id, const HttpMsgReader::Message& msg) {
         return false;
     }
 
+    if (_busyConnections.count(id)) {
+        // responses must go in order, pipelining isn't supported
+        LOG_DEBUG() << STS << "-peer " << io::Address::from_u64(id) << " : pipelined request";
+        it->second->shutdown();
+        _connections.erase(it);
+        return false;
+    }
+
     const std::string& path = msg.msg->get_path();
 
     static const std::map<std::string_view, int> dirs {
@@ -154,6 +271,9 @@ bool Server::send_status(const HttpConnection::Ptr& conn) {
 
 bool Server::send_block(const HttpConnection::Ptr &conn) {
     auto height = _currentUrl.get_int_arg("height", 0);
+    if (!_workers.empty()) {
+        return post_job(conn, DIR_BLOCK, height, 0);
+    }
     if (!_backend.get_block(_body, height)) {
         return send(conn, 500, "Internal error #2");
     }
@@ -166,6 +286,9 @@ bool Server::send_blocks(const HttpConnection::Ptr& conn) {
     if (start <= 0 || n < 0) {
         return send(conn, 400, "Bad request");
     }
+    if (!_workers.empty()) {
+        return post_job(conn, DIR_BLOCKS, start, n);
+    }
     if (!_backend.get_blocks(_body, start, n)) {
         return send(conn, 500, "Internal error #3");
     }
@@ -16,19 +16,43 @@
 #include "http/http_msg_creator.h"
 #include "utility/io/tcpserver.h"
 #include "utility/io/coarsetimer.h"
+#include "utility/io/asyncevent.h"
 #include "utility/helpers.h"
 #include <string_view>
 #include <set>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace beam { namespace explorer {
 
 struct IAdapter;
+struct IBlockReader;
 
 class Server {
 public:
-    Server(IAdapter& adapter, io::Reactor& reactor, io::Address bindAddress, const std::string& keysFileName);
+    /// If numWorkers > 0 then /block and /blocks are served by the worker threads, each on its own read-only db connection
+    Server(IAdapter& adapter, io::Reactor& reactor, io::Address bindAddress, const std::string& keysFileName, unsigned numWorkers=0);
+    ~Server();
 
 private:
+    /// Block request, served by a worker
+    struct Job {
+        uint64_t connId;
+        int dir;
+        uint64_t height;
+        uint64_t n;
+        io::SerializedMsg body;
+        bool ok;
+    };
+
+    void start_workers(unsigned numWorkers);
+    void stop_workers();
+    void worker_thread(IBlockReader& reader);
+    bool post_job(const HttpConnection::Ptr& conn, int dir, uint64_t height, uint64_t n);
+    void on_jobs_done();
+
     class IPAccessControl {
     public:
         explicit IPAccessControl(const std::string& ipsFileName);
@@ -66,6 +90,18 @@ private:
     io::SerializedMsg _body;
     //AccessControl _acl;
     IPAccessControl _acl;
+
+    std::vector<std::unique_ptr<IBlockReader>> _readers;
+    std::vector<std::thread> _workers;
+    std::mutex _jobsMutex;
+    std::condition_variable _jobsCond;
+    std::deque<Job> _jobsPending;
+    std::deque<Job> _jobsDone;
+    bool _stopWorkers=false;
+    io::AsyncEvent::Ptr _jobsDoneEvent;
+
+    // connections with a job in progress
+    std::set<uint64_t> _busyConnections;
 };
 
 }} //namespaces
@@ -0,0 +1,206 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "block_store.h"
+
+#ifndef WIN32
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif // WIN32
+
+namespace beam {
+
+void BlockStore::get_Path(std::string& s, uint32_t iSegment) const
+{
+	char sz[0x10];
+	snprintf(sz, _countof(sz), ".blk%06u", iSegment);
+
+	s = m_sPathPrefix + sz;
+}
+
+void BlockStore::Open(const char* szPathPrefix, uint32_t iSegment, bool bNew)
+{
+	Close();
+
+	m_sPathPrefix = szPathPrefix;
+	m_iActive = iSegment;
+	OpenActive(bNew);
+}
+
+void BlockStore::OpenReadOnly(const char* szPathPrefix)
+{
+	Close();
+	m_sPathPrefix = szPathPrefix;
+}
+
+void BlockStore::Close()
+{
+	m_fActive.Close();
+	m_mapMapped.clear();
+	m_nActive = 0;
+	m_bDirty = false; // the committed data is already synced
+}
+
+void BlockStore::OpenActive(bool bNew)
+{
+	std::string s;
+	get_Path(s, m_iActive);
+
+	m_nActive = 0;
+	if (!bNew)
+	{
+		std::FStream f;
+		if (f.Open(s.c_str(), true))
+			m_nActive = f.get_Remaining();
+	}
+
+	// new segment is truncated, there may be a stale file from the previous incarnation
+	m_fActive.Open(s.c_str(), false, true, !bNew);
+}
+
+void BlockStore::Append(const Blob& b, Pos& pos)
+{
+	if (!m_fActive.IsOpen())
+		throw std::runtime_error("block store is read-only");
+
+	if (m_nActive >= m_SegmentSize)
+	{
+		Sync();
+		m_fActive.Close();
+		m_iActive++;
+		OpenActive(true);
+	}
+
+	pos.m_Segment = m_iActive;
+	pos.m_Size = b.n;
+	pos.m_Offset = m_nActive;
+
+	m_fActive.write(b.p, b.n);
+	m_fActive.Flush(); // must be visible to the readers
+
+	m_nActive += b.n;
+	m_bDirty = true;
+}
+
+void BlockStore::Sync()
+{
+	if (!m_bDirty)
+		return;
+
+	std::string s;
+	get_Path(s, m_iActive);
+	SyncFile(s.c_str());
+
+	m_bDirty = false;
+}
+
+void BlockStore::SyncFile(const char* sz)
+{
+	// the stream is already flushed to the OS, any handle to the file would do
+#ifdef WIN32
+	HANDLE h = CreateFileW(Utf8toUtf16(sz).c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, NULL);
+	if (INVALID_HANDLE_VALUE == h)
+		throw std::runtime_error("block store sync failed");
+
+	BOOL bOk = FlushFileBuffers(h);
+	CloseHandle(h);
+#else // WIN32
+	int hFile = open(sz, O_RDONLY);
+	if (hFile < 0)
+		throw std::runtime_error("block store sync failed");
+
+	bool bOk = !fsync(hFile);
+	close(hFile);
+#endif // WIN32
+
+	if (!bOk)
+		throw std::runtime_error("block store sync failed");
+}
+
+const uint8_t* BlockStore::get_Data(const Pos& pos, io::SharedBuffer* pGuard)
+{
+	uint32_t iSegment, nSize;
+	uint64_t nOffset;
+	pos.m_Segment.Export(iSegment);
+	pos.m_Size.Export(nSize);
+	pos.m_Offset.Export(nOffset);
+
+	uint64_t nEnd = nOffset + nSize;
+
+	io::SharedBuffer& buf = m_mapMapped[iSegment];
+	if (buf.size < nEnd)
+	{
+		// map (or re-map, the active segment grows). Those who referenced the previous mapping still hold it
+		std::string s;
+		get_Path(s, iSegment);
+
+		try {
+			buf = io::map_file_read_only(s.c_str());
+		} catch (const std::exception& e) {
+			m_mapMapped.erase(iSegment);
+			throw SegmentMissing(e.what());
+		}
+
+		if (buf.size < nEnd)
+			throw std::runtime_error("block store underflow");
+	}
+
+	if (pGuard)
+		pGuard->assign(buf.data + nOffset, nSize, buf.guard);
+
+	return buf.data + nOffset;
+}
+
+void BlockStore::Read(const Pos& pos, ByteBuffer& bb)
+{
+	uint32_t nSize;
+	pos.m_Size.Export(nSize);
+
+	const uint8_t* p = get_Data(pos, NULL);
+	bb.assign(p, p + nSize);
+}
+
+void BlockStore::Read(const Pos& pos, io::SharedBuffer& buf)
+{
+	get_Data(pos, &buf);
+}
+
+bool BlockStore::DeleteSegment(uint32_t iSegment)
+{
+	assert(iSegment != m_iActive);
+	Unmap(iSegment);
+
+	std::string s;
+	get_Path(s, iSegment);
+	if (DeleteFile(s.c_str()))
+		return true;
+
+	std::FStream f;
+	return !f.Open(s.c_str(), true); // already absent
+}
+
+void BlockStore::get_Mapped(std::vector<uint32_t>& v) const
+{
+	v.clear();
+	for (std::map<uint32_t, io::SharedBuffer>::const_iterator it = m_mapMapped.begin(); m_mapMapped.end() != it; it++)
+		v.push_back(it->first);
+}
+
+void BlockStore::Unmap(uint32_t iSegment)
+{
+	m_mapMapped.erase(iSegment); // those who referenced the mapping still hold it
+}
+
+} // namespace beam
@@ -0,0 +1,83 @@
+// Copyright 2018 The Beam Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include "core/common.h"
+#include "core/uintBig.h"
+#include "utility/io/buffer.h"
+
+namespace beam {
+
+// Append-only storage of the block bodies and rollback data, split into segment files.
+// The positions are indexed by the NodeDB, the space of the pruned blocks is reclaimed by deleting the whole segments once they're unused.
+// The appended data is synced to the disk before the DB commit that references it. After a crash the segment may only contain an unreferenced tail.
+class BlockStore
+{
+public:
+
+	static const uint32_t s_SegmentSizeDef = 64 << 20;
+	uint32_t m_SegmentSize = s_SegmentSizeDef; // the next segment is started once this size is reached
+
+#pragma pack (push, 1)
+	struct Pos
+	{
+		uintBigFor<uint32_t>::Type m_Segment;
+		uintBigFor<uint32_t>::Type m_Size;
+		uintBigFor<uint64_t>::Type m_Offset;
+	};
+#pragma pack (pop)
+
+	void Open(const char* szPathPrefix, uint32_t iSegment, bool bNew); // the active segment to append to
+	void OpenReadOnly(const char* szPathPrefix); // appending is not allowed
+	void Close();
+
+	uint32_t get_Active() const { return m_iActive; }
+
+	void Append(const Blob&, Pos&); // may start the next segment
+	void Sync(); // flush the appended data to the disk. Must precede the commit of the DB that references it
+	void Read(const Pos&, ByteBuffer&);
+	void Read(const Pos&, io::SharedBuffer&); // zero-copy, references the mapped segment
+
+	bool DeleteSegment(uint32_t); // must not be the active one. May fail on Windows while the segment is mapped (by readers or those who hold its buffers)
+
+	// Readers (read-only stores) keep the segments mapped. Those deleted by the writer should be unmapped, so that the disk space is reclaimed
+	void get_Mapped(std::vector<uint32_t>&) const;
+	void Unmap(uint32_t);
+
+	// The segment can't be mapped. For a reader - the writer may have deleted it after the reader's DB snapshot was taken, retry with the new snapshot
+	struct SegmentMissing
+		:public std::runtime_error
+	{
+		SegmentMissing(const std::string& s) :std::runtime_error(s) {}
+	};
+
+private:
+
+	std::string m_sPathPrefix;
+	uint32_t m_iActive = 0;
+	uint64_t m_nActive = 0; // size
+	std::FStream m_fActive;
+	bool m_bDirty = false; // appended since the last sync
+
+	std::map<uint32_t, io::SharedBuffer> m_mapMapped;
+
+	void get_Path(std::string&, uint32_t iSegment) const;
+	static void SyncFile(const char*);
+	void OpenActive(bool bNew);
+	const uint8_t* get_Data(const Pos&, io::SharedBuffer* pGuard);
+};
+
+} // namespace beam
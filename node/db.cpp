@@ -76,6 +76,10 @@ namespace beam {
 #define TblDummy_Key			"Key"
 #define TblDummy_SpendHeight	"SpendHeight"
 
+#define TblBlkSegs				"BlockSegments"
+#define TblBlkSegs_ID			"ID"
+#define TblBlkSegs_Live			"Live"
+
 NodeDB::NodeDB()
 	:m_pDb(NULL)
 {
@@ -114,6 +118,14 @@ void NodeDB::Close()
 {
 	if (m_pDb)
 	{
+		if (!m_vSegmentsReleased.empty())
+		{
+			try {
+				OnCommitted(); // last chance
+			} catch (const std::exception&) {
+			}
+		}
+
 		for (size_t i = 0; i < _countof(m_pPrep); i++)
 		{
 			sqlite3_stmt*& pStmt = m_pPrep[i];
@@ -126,6 +138,15 @@ void NodeDB::Close()
 
 		verify(SQLITE_OK == sqlite3_close(m_pDb));
 		m_pDb = NULL;
+
+		m_BlockStore.Close();
+		m_vSegmentsUnused.clear();
+		m_vSegmentsReleased.clear();
+		m_bWal = false;
+		m_Synchronous = 2;
+
+		m_KrnFilter.m_bEnabled = false;
+		m_KrnFilter.m_bValid = false;
 	}
 }
 
@@ -241,10 +262,13 @@ const void* NodeDB::Recordset::get_BlobStrict(int col, uint32_t n)
 	return x.p;
 }
 
-void NodeDB::Open(const char* szPath)
+void NodeDB::Open(const char* szPath, const Profile* pProfile /* = NULL */)
 {
 	TestRet(sqlite3_open_v2(szPath, &m_pDb, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_CREATE, NULL));
 
+	if (pProfile)
+		SetProfile(*pProfile);
+
 	bool bCreate;
 	{
 		Recordset rs(*this, Query::Scheme, "SELECT name FROM sqlite_master WHERE type='table' AND name=?");
@@ -252,21 +276,84 @@ void NodeDB::Open(const char* szPath)
 		bCreate = !rs.Step();
 	}
 
-	const uint64_t nVersion = 13;
-
 	if (bCreate)
 	{
 		Transaction t(*this);
 		Create();
+
+		uint64_t nVersion = s_Version;
 		ParamSet(ParamID::DbVer, &nVersion, NULL);
 		t.Commit();
 	}
 	else
+		TestVersion();
+
+	// resume appending to the last segment. If there's none - start anew
+	uint32_t iSegment = 0;
+	bool bNewSegment = true;
+	{
+		Recordset rs(*this, Query::BlkSegMax, "SELECT MAX(" TblBlkSegs_ID ") FROM " TblBlkSegs);
+		if (rs.Step() && !rs.IsNull(0))
+		{
+			rs.get(0, iSegment);
+			bNewSegment = false;
+		}
+	}
+
+	m_BlockStore.Open(szPath, iSegment, bNewSegment);
+
+	if (!bNewSegment)
+		DeleteOrphanSegments(iSegment);
+
+	m_KrnFilter.m_bEnabled = true;
+	KernelFilterRebuild();
+}
+
+void NodeDB::OpenReadOnly(const char* szPath)
+{
+	TestRet(sqlite3_open_v2(szPath, &m_pDb, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL));
+
+	TestVersion();
+	m_BlockStore.OpenReadOnly(szPath);
+}
+
+void NodeDB::TestVersion()
+{
+	if (s_Version != ParamIntGetDef(ParamID::DbVer))
+		ThrowError("wrong version");
+}
+
+void NodeDB::SetProfile(const Profile& p)
+{
+	char sz[0x40];
+
+	if (p.m_PageSize)
+	{
+		// must precede any table creation
+		snprintf(sz, _countof(sz), "PRAGMA page_size=%u", p.m_PageSize);
+		ExecQuick(sz);
+	}
+
+	if (p.m_CacheSize)
+	{
+		snprintf(sz, _countof(sz), "PRAGMA cache_size=%d", p.m_CacheSize);
+		ExecQuick(sz);
+	}
+
+	if (p.m_MmapSize)
 	{
-		// test the DB version
-		if (nVersion != ParamIntGetDef(ParamID::DbVer))
-			ThrowError("wrong version");
+		snprintf(sz, _countof(sz), "PRAGMA mmap_size=%llu", (unsigned long long) p.m_MmapSize);
+		ExecQuick(sz);
 	}
+
+	// journal mode is persistent, set it explicitly either way
+	ExecQuick(p.m_Wal ? "PRAGMA journal_mode=WAL" : "PRAGMA journal_mode=DELETE");
+
+	snprintf(sz, _countof(sz), "PRAGMA synchronous=%u", p.m_Synchronous);
+	ExecQuick(sz);
+
+	m_bWal = p.m_Wal;
+	m_Synchronous = p.m_Synchronous;
 }
 
 void NodeDB::Create()
@@ -357,6 +444,10 @@ void NodeDB::Create()
 		"[" TblDummy_SpendHeight	"] INTEGER NOT NULL)");
 
 	ExecQuick("CREATE INDEX [Idx" TblDummy "H] ON [" TblDummy "] ([" TblDummy_SpendHeight "]);");
+
+	ExecQuick("CREATE TABLE [" TblBlkSegs "] ("
+		"[" TblBlkSegs_ID		"] INTEGER NOT NULL PRIMARY KEY,"
+		"[" TblBlkSegs_Live		"] INTEGER NOT NULL)");
 }
 
 void NodeDB::ExecQuick(const char* szSql)
@@ -462,7 +553,7 @@ void NodeDB::ParamSet(uint32_t ID, const uint64_t* p0, const Blob* p1)
 	}
 }
 
-bool NodeDB::ParamGet(uint32_t ID, uint64_t* p0, Blob* p1)
+bool NodeDB::ParamGet(uint32_t ID, uint64_t* p0, Blob* p1, ByteBuffer* p2 /* = NULL */)
 {
 	Recordset rs(*this, Query::ParamGet, "SELECT " TblParams_Int "," TblParams_Blob " FROM " TblParams " WHERE " TblParams_ID "=?");
 	rs.put(0, ID);
@@ -477,6 +568,8 @@ bool NodeDB::ParamGet(uint32_t ID, uint64_t* p0, Blob* p1)
 		const void* pPtr = rs.get_BlobStrict(1, p1->n);
 		memcpy((void*) p1->p, pPtr, p1->n);
 	}
+	if (p2)
+		rs.get(1, *p2);
 
 	return true;
 }
@@ -499,6 +592,13 @@ NodeDB::Transaction::~Transaction()
 	Rollback();
 }
 
+NodeDB::Snapshot::Snapshot(NodeDB& db)
+	:m_Tx(db)
+{
+	db.TestVersion(); // the snapshot is taken by the 1st read
+	db.UnmapDeletedSegments();
+}
+
 void NodeDB::Transaction::Start(NodeDB& db)
 {
 	assert(!m_pDB);
@@ -509,7 +609,9 @@ void NodeDB::Transaction::Start(NodeDB& db)
 void NodeDB::Transaction::Commit()
 {
 	assert(m_pDB);
+	m_pDB->m_BlockStore.Sync(); // the DB must not reference the data that may be lost on crash
 	m_pDB->ExecStep(Query::Commit, "COMMIT");
+	m_pDB->OnCommitted();
 	m_pDB = NULL;
 }
 
@@ -522,6 +624,8 @@ void NodeDB::Transaction::Rollback()
 		} catch (std::exception&) {
 			// TODO: DB is compromised!
 		}
+		m_pDB->m_vSegmentsUnused.clear(); // still referenced
+		m_pDB->m_KrnFilter.m_bValid = false; // may contain rolled-back kernels
 		m_pDB = NULL;
 	}
 }
@@ -722,6 +826,8 @@ bool NodeDB::DeleteState(uint64_t rowid, uint64_t& rowPrev)
 	if (StateFlags::Reachable & nFlags)
 		TipReachableDel(rowid);
 
+	ReleaseStateBlock(rowid, true, true);
+
 	rs.Reset(Query::StateDel, "DELETE FROM " TblStates " WHERE rowid=?");
 	rs.put(0, rowid);
 
@@ -994,13 +1100,203 @@ bool NodeDB::get_Peer(uint64_t rowid, PeerID& peer)
 	return true;
 }
 
+bool NodeDB::get_BlockPos(Recordset& rs, int col, BlockStore::Pos& pos)
+{
+	if (rs.IsNull(col))
+		return false;
+
+	rs.get_As(col, pos);
+	return true;
+}
+
+void NodeDB::BlockPut(const Blob& b, BlockStore::Pos& pos)
+{
+	uint32_t iPrev = m_BlockStore.get_Active();
+	m_BlockStore.Append(b, pos);
+
+	if (sqlite3_get_autocommit(m_pDb))
+		m_BlockStore.Sync(); // no transaction in progress, the position is committed right away
+
+	uint32_t iSegment;
+	pos.m_Segment.Export(iSegment);
+
+	Recordset rs(*this, Query::BlkSegAdd, "UPDATE " TblBlkSegs " SET " TblBlkSegs_Live "=" TblBlkSegs_Live "+? WHERE " TblBlkSegs_ID "=?");
+	rs.put(0, b.n);
+	rs.put(1, iSegment);
+	rs.Step();
+
+	if (get_RowsChanged())
+		return;
+
+	rs.Reset(Query::BlkSegIns, "INSERT INTO " TblBlkSegs "(" TblBlkSegs_ID "," TblBlkSegs_Live ") VALUES(?,?)");
+	rs.put(0, iSegment);
+	rs.put(1, b.n);
+	rs.Step();
+	TestChanged1Row();
+
+	if (iPrev != iSegment)
+	{
+		// the previous segment is no longer active. Maybe it's unused already
+		rs.Reset(Query::BlkSegGet, "SELECT " TblBlkSegs_Live " FROM " TblBlkSegs " WHERE " TblBlkSegs_ID "=?");
+		rs.put(0, iPrev);
+
+		uint64_t nLive = 0;
+		if (rs.Step())
+			rs.get(0, nLive);
+
+		if (!nLive)
+			OnSegmentUnused(iPrev);
+	}
+}
+
+void NodeDB::BlockRelease(const BlockStore::Pos& pos)
+{
+	uint32_t iSegment, nSize;
+	pos.m_Segment.Export(iSegment);
+	pos.m_Size.Export(nSize);
+
+	Recordset rs(*this, Query::BlkSegSub, "UPDATE " TblBlkSegs " SET " TblBlkSegs_Live "=" TblBlkSegs_Live "-? WHERE " TblBlkSegs_ID "=?");
+	rs.put(0, nSize);
+	rs.put(1, iSegment);
+	rs.Step();
+	TestChanged1Row();
+
+	if (iSegment == m_BlockStore.get_Active())
+		return;
+
+	rs.Reset(Query::BlkSegGet, "SELECT " TblBlkSegs_Live " FROM " TblBlkSegs " WHERE " TblBlkSegs_ID "=?");
+	rs.put(0, iSegment);
+	rs.StepStrict();
+
+	uint64_t nLive;
+	rs.get(0, nLive);
+
+	if (!nLive)
+		OnSegmentUnused(iSegment);
+}
+
+void NodeDB::OnSegmentUnused(uint32_t iSegment)
+{
+	assert(iSegment != m_BlockStore.get_Active());
+
+	Recordset rs(*this, Query::BlkSegDel, "DELETE FROM " TblBlkSegs " WHERE " TblBlkSegs_ID "=?");
+	rs.put(0, iSegment);
+	rs.Step();
+
+	m_vSegmentsUnused.push_back(iSegment);
+
+	if (sqlite3_get_autocommit(m_pDb))
+		OnCommitted(); // no transaction in progress
+}
+
+void NodeDB::DeleteOrphanSegments(uint32_t iActive)
+{
+	// segments released by the durable commits, but not deleted before the shutdown (crash, or delete failure)
+	std::vector<uint32_t> v;
+	{
+		Recordset rs(*this, Query::BlkSegEnum, "SELECT " TblBlkSegs_ID " FROM " TblBlkSegs " ORDER BY " TblBlkSegs_ID);
+		while (rs.Step())
+		{
+			v.emplace_back();
+			rs.get(0, v.back());
+		}
+	}
+
+	size_t iPos = 0;
+	for (uint32_t iSegment = 0; iSegment < iActive; iSegment++)
+	{
+		if ((iPos < v.size()) && (v[iPos] == iSegment))
+			iPos++;
+		else
+			m_BlockStore.DeleteSegment(iSegment);
+	}
+}
+
+void NodeDB::UnmapDeletedSegments()
+{
+	// for readers. The segments absent in the current snapshot are not referenced anymore, and may be already deleted by the writer
+	std::vector<uint32_t> v;
+	m_BlockStore.get_Mapped(v);
+
+	for (size_t i = 0; i < v.size(); i++)
+	{
+		Recordset rs(*this, Query::BlkSegGet, "SELECT " TblBlkSegs_Live " FROM " TblBlkSegs " WHERE " TblBlkSegs_ID "=?");
+		rs.put(0, v[i]);
+		if (!rs.Step())
+			m_BlockStore.Unmap(v[i]);
+	}
+}
+
+void NodeDB::OnCommitted()
+{
+	m_vSegmentsReleased.insert(m_vSegmentsReleased.end(), m_vSegmentsUnused.begin(), m_vSegmentsUnused.end());
+	m_vSegmentsUnused.clear();
+
+	if (m_vSegmentsReleased.empty() || !IsCommitDurable())
+		return; // if the commit is lost on crash - the DB would still reference the deleted segments. Retry after the next commit
+
+	// those that can't be deleted now (Windows, mapped by someone) are retried after the next commit
+	size_t nFailed = 0;
+	for (size_t i = 0; i < m_vSegmentsReleased.size(); i++)
+		if (!m_BlockStore.DeleteSegment(m_vSegmentsReleased[i]))
+			m_vSegmentsReleased[nFailed++] = m_vSegmentsReleased[i];
+
+	m_vSegmentsReleased.resize(nFailed);
+}
+
+bool NodeDB::IsCommitDurable()
+{
+	// OFF: no guarantees anyway. FULL and above, or the rollback journal: the commit is synced
+	if (!m_bWal || (1 != m_Synchronous))
+		return true;
+
+	// WAL with NORMAL: the WAL is synced only by the checkpoint. Passive - don't wait for the readers, fails if they hold the older frames
+	Recordset rs(*this, Query::WalCheckpoint, "PRAGMA wal_checkpoint(PASSIVE)");
+	if (!rs.Step())
+		return false;
+
+	uint64_t nBusy, nLog, nCheckpointed;
+	rs.get(0, nBusy);
+	rs.get(1, nLog);
+	rs.get(2, nCheckpointed);
+
+	return !nBusy && (nLog == nCheckpointed);
+}
+
+void NodeDB::ReleaseStateBlock(uint64_t rowid, bool bBody, bool bRollback)
+{
+	Recordset rs(*this, Query::StateGetBlock, "SELECT " TblStates_BodyP "," TblStates_BodyE "," TblStates_Rollback " FROM " TblStates " WHERE rowid=?");
+	rs.put(0, rowid);
+	rs.StepStrict();
+
+	BlockStore::Pos pPos[3];
+	bool pValid[3];
+
+	for (int i = 0; i < 3; i++)
+		pValid[i] = get_BlockPos(rs, i, pPos[i]) && ((i < 2) ? bBody : bRollback);
+
+	rs.Reset();
+
+	for (int i = 0; i < 3; i++)
+		if (pValid[i])
+			BlockRelease(pPos[i]);
+}
+
 void NodeDB::SetStateBlock(uint64_t rowid, const Blob& bodyP, const Blob& bodyE)
 {
+	ReleaseStateBlock(rowid, true, false); // if overwritten
+
+	BlockStore::Pos posP, posE;
+	if (bodyP.n)
+		BlockPut(bodyP, posP);
+	if (bodyE.n)
+		BlockPut(bodyE, posE);
+
 	Recordset rs(*this, Query::StateSetBlock, "UPDATE " TblStates " SET " TblStates_BodyP "=?," TblStates_BodyE "=? WHERE rowid=?");
 	if (bodyP.n)
-		rs.put(0, bodyP);
+		rs.put_As(0, posP);
 	if (bodyE.n)
-		rs.put(1, bodyE);
+		rs.put_As(1, posE);
 	rs.put(2, rowid);
 
 	rs.Step();
@@ -1013,18 +1309,39 @@ void NodeDB::GetStateBlock(uint64_t rowid, ByteBuffer* pP, ByteBuffer* pE, ByteB
 	rs.put(0, rowid);
 	rs.StepStrict();
 
-	if (pP && !rs.IsNull(0))
-		rs.get(0, *pP);
-	if (pE && !rs.IsNull(1))
-		rs.get(1, *pE);
-	if (pRollback && !rs.IsNull(2))
-		rs.get(2, *pRollback);
+	ByteBuffer* ppBuf[] = { pP, pE, pRollback };
+	BlockStore::Pos pos;
+
+	for (size_t i = 0; i < _countof(ppBuf); i++)
+		if (ppBuf[i] && get_BlockPos(rs, i, pos))
+			m_BlockStore.Read(pos, *ppBuf[i]);
+}
+
+void NodeDB::GetStateBlock(uint64_t rowid, io::SharedBuffer* pP, io::SharedBuffer* pE)
+{
+	Recordset rs(*this, Query::StateGetBlock, "SELECT " TblStates_BodyP "," TblStates_BodyE "," TblStates_Rollback " FROM " TblStates " WHERE rowid=?");
+	rs.put(0, rowid);
+	rs.StepStrict();
+
+	io::SharedBuffer* ppBuf[] = { pP, pE };
+	BlockStore::Pos pos;
+
+	for (size_t i = 0; i < _countof(ppBuf); i++)
+		if (ppBuf[i] && get_BlockPos(rs, i, pos))
+			m_BlockStore.Read(pos, *ppBuf[i]);
 }
 
 void NodeDB::SetStateRollback(uint64_t rowid, const Blob& rollback)
 {
+	ReleaseStateBlock(rowid, false, true); // if overwritten
+
+	BlockStore::Pos pos;
+	if (rollback.n)
+		BlockPut(rollback, pos);
+
 	Recordset rs(*this, Query::StateSetRollback, "UPDATE " TblStates " SET " TblStates_Rollback "=? WHERE rowid=?");
-	rs.put(0, rollback);
+	if (rollback.n)
+		rs.put_As(0, pos);
 	rs.put(1, rowid);
 
 	rs.Step();
@@ -1041,9 +1358,13 @@ void NodeDB::SetStateRollback(uint64_t rowid, const Blob& rollback)
 
 void NodeDB::DelStateBlockAll(uint64_t rowid)
 {
-	Blob bEmpty(NULL, 0);
-	SetStateBlock(rowid, bEmpty, bEmpty);
-	SetStateRollback(rowid, bEmpty);
+	ReleaseStateBlock(rowid, true, true);
+
+	Recordset rs(*this, Query::StateDelBlock, "UPDATE " TblStates " SET " TblStates_BodyP "=NULL," TblStates_BodyE "=NULL," TblStates_Rollback "=NULL WHERE rowid=?");
+	rs.put(0, rowid);
+
+	rs.Step();
+	TestChanged1Row();
 }
 
 void NodeDB::SetFlags(uint64_t rowid, uint32_t n)
@@ -1664,8 +1985,16 @@ void NodeDB::ResetCursor()
 	rs.Reset(Query::KernelDelAll, "DELETE FROM " TblKernels);
 	rs.Step();
 
+	if (m_KrnFilter.m_bEnabled)
+	{
+		m_KrnFilter.Reset(0);
+		m_KrnFilter.m_bValid = true;
+	}
+
 	DeleteEventsAbove(Rules::HeightGenesis - 1);
 
+	ParamSet(ParamID::UtxoSnapshot, NULL, NULL); // no longer valid
+
 	StateID sid;
 	sid.m_Row = 0;
 	sid.m_Height = Rules::HeightGenesis - 1;
@@ -1681,6 +2010,9 @@ void NodeDB::InsertKernel(const Blob& key, Height h)
 	rs.put(1, h);
 	rs.Step();
 	TestChanged1Row();
+
+	if (m_KrnFilter.m_bValid)
+		m_KrnFilter.Add(key);
 }
 
 void NodeDB::DeleteKernel(const Blob& key, Height h)
@@ -1695,18 +2027,39 @@ void NodeDB::DeleteKernel(const Blob& key, Height h)
 	uint32_t nRows = get_RowsChanged();
 	if (!nRows)
 		ThrowError("no krn");
-	else
-		// in the *very* unlikely case of kernel duplicate at the same height (!!!) - just re-insert it
-		while (--nRows)
-			InsertKernel(key, h);
+
+	if (m_KrnFilter.m_bValid)
+		for (uint32_t i = 0; i < nRows; i++)
+			m_KrnFilter.Remove(key);
+
+	// in the *very* unlikely case of kernel duplicate at the same height (!!!) - just re-insert it
+	while (--nRows)
+		InsertKernel(key, h);
 }
 
 Height NodeDB::FindKernel(const Blob& key)
 {
+	if (m_KrnFilter.m_bEnabled)
+	{
+		if (!m_KrnFilter.m_bValid)
+			KernelFilterRebuild();
+
+		m_KrnFilterStats.m_Lookups++;
+		if (!m_KrnFilter.MayContain(key))
+		{
+			m_KrnFilterStats.m_Negatives++;
+			return Rules::HeightGenesis - 1;
+		}
+	}
+
 	Recordset rs(*this, Query::KernelFind, "SELECT " TblKernels_Height " FROM " TblKernels " WHERE " TblKernels_Key "=? ORDER BY " TblKernels_Height " DESC LIMIT 1");
 	rs.put(0, key);
 	if (!rs.Step())
+	{
+		if (m_KrnFilter.m_bEnabled)
+			m_KrnFilterStats.m_FalsePositives++;
 		return Rules::HeightGenesis - 1;
+	}
 
 	Height h;
 	rs.get(0, h);
@@ -1715,4 +2068,105 @@ Height NodeDB::FindKernel(const Blob& key)
 	return h;
 }
 
+void NodeDB::KernelFilterRebuild()
+{
+	uint64_t nCount = 0;
+	{
+		Recordset rs(*this, Query::KernelCount, "SELECT COUNT(*) FROM " TblKernels);
+		if (rs.Step())
+			rs.get(0, nCount);
+	}
+
+	m_KrnFilter.Reset(nCount * 2); // leave room for growth
+
+	Recordset rs(*this, Query::KernelEnum, "SELECT " TblKernels_Key " FROM " TblKernels);
+	while (rs.Step())
+	{
+		Blob key;
+		rs.get(0, key);
+		m_KrnFilter.Add(key);
+	}
+
+	m_KrnFilter.m_bValid = true;
+}
+
+void NodeDB::KernelFilter::Reset(uint64_t nCapacity)
+{
+	size_t nSize = size_t(1) << 14;
+	while (nSize < nCapacity * s_CountersPerKrn)
+		nSize <<= 1;
+
+	m_vCounters.assign(nSize, 0);
+	m_Count = 0;
+}
+
+void NodeDB::KernelFilter::get_Indexes(const Blob& key, uint32_t* pIdx) const
+{
+	// kernel IDs are hashes already, use their bytes directly
+	const uint8_t* p = reinterpret_cast<const uint8_t*>(key.p);
+
+	ECC::Hash::Value hv;
+	if (key.n < sizeof(uint32_t) * s_Hashes)
+	{
+		ECC::Hash::Processor() << key >> hv;
+		p = hv.m_pData;
+	}
+
+	uint32_t nMask = static_cast<uint32_t>(m_vCounters.size() - 1);
+	for (uint32_t i = 0; i < s_Hashes; i++, p += sizeof(uint32_t))
+		pIdx[i] = (uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24)) & nMask;
+}
+
+void NodeDB::KernelFilter::Add(const Blob& key)
+{
+	if ((m_Count + 1) * s_CountersPerKrn > m_vCounters.size())
+	{
+		m_bValid = false; // overloaded, will be rebuilt with a larger size
+		return;
+	}
+
+	m_Count++;
+
+	uint32_t pIdx[s_Hashes];
+	get_Indexes(key, pIdx);
+
+	for (uint32_t i = 0; i < s_Hashes; i++)
+	{
+		uint8_t& x = m_vCounters[pIdx[i]];
+		if (x < 0xff)
+			x++;
+	}
+}
+
+void NodeDB::KernelFilter::Remove(const Blob& key)
+{
+	assert(m_Count);
+	m_Count--;
+
+	uint32_t pIdx[s_Hashes];
+	get_Indexes(key, pIdx);
+
+	for (uint32_t i = 0; i < s_Hashes; i++)
+	{
+		uint8_t& x = m_vCounters[pIdx[i]];
+		if (x < 0xff) // saturated counters are never decremented
+		{
+			assert(x);
+			x--;
+		}
+	}
+}
+
+bool NodeDB::KernelFilter::MayContain(const Blob& key) const
+{
+	uint32_t pIdx[s_Hashes];
+	get_Indexes(key, pIdx);
+
+	for (uint32_t i = 0; i < s_Hashes; i++)
+		if (!m_vCounters[pIdx[i]])
+			return false;
+
+	return true;
+}
+
 } // namespace beam
@@ -16,6 +16,7 @@
 
 #include "core/common.h"
 #include "core/block_crypt.h"
+#include "block_store.h"
 #include "sqlite/sqlite3.h"
 
 namespace beam {
@@ -40,6 +41,7 @@ public:
 			MyID,
 			SyncTarget,
 			LoHorizon,
+			UtxoSnapshot,
 		};
 	};
 
@@ -92,8 +94,15 @@ public:
 			HashForHist,
 			StateGetBlock,
 			StateSetBlock,
-			//StateDelBlock,
+			StateDelBlock,
 			StateSetRollback,
+			BlkSegMax,
+			BlkSegIns,
+			BlkSegAdd,
+			BlkSegSub,
+			BlkSegGet,
+			BlkSegDel,
+			BlkSegEnum,
 			EventIns,
 			EventDel,
 			EventEnum,
@@ -117,6 +126,9 @@ public:
 			KernelFind,
 			KernelDel,
 			KernelDelAll,
+			KernelCount,
+			KernelEnum,
+			WalCheckpoint,
 
 			Dbg0,
 			Dbg1,
@@ -132,8 +144,23 @@ public:
 	NodeDB();
 	virtual ~NodeDB();
 
+	struct Profile
+	{
+		// sqlite tuning. Applied on open, 0 - leave the sqlite default
+		bool m_Wal = true; // write-ahead log: readers (secondary connections) and the writer don't block each other
+		// 0: OFF, 1: NORMAL, 2: FULL, 3: EXTRA.
+		// NORMAL is safe with WAL (no corruption), but the last commits may be lost on power failure. Hence the block store segments released
+		// by a commit are deleted only once it's known to be durable (after a successful WAL checkpoint), otherwise they're retried after the next commit.
+		uint8_t m_Synchronous = 1;
+		uint32_t m_PageSize = 0; // effective for the newly-created DB only
+		int32_t m_CacheSize = -64 * 1024; // positive - pages, negative - KiB
+		uint64_t m_MmapSize = 256 * 1024 * 1024;
+	};
+
 	void Close();
-	void Open(const char* szPath);
+	void Open(const char* szPath, const Profile* = NULL); // no profile - sqlite defaults
+	void OpenReadOnly(const char* szPath); // secondary connection, sees only the committed data. The DB must already exist
+	void set_BlockSegmentSize(uint32_t n) { m_BlockStore.m_SegmentSize = n; } // for the segments started from now on
 
 	virtual void OnModified() {}
 
@@ -197,10 +224,18 @@ public:
 		void Rollback();
 	};
 
+	// Read transaction, pins the state seen by all the reads within the scope. For the readers on secondary (read-only) connections,
+	// while the writer proceeds concurrently (WAL).
+	class Snapshot {
+		Transaction m_Tx;
+	public:
+		Snapshot(NodeDB&);
+	};
+
 	// Hi-level functions
 
 	void ParamSet(uint32_t ID, const uint64_t*, const Blob*);
-	bool ParamGet(uint32_t ID, uint64_t*, Blob*);
+	bool ParamGet(uint32_t ID, uint64_t*, Blob*, ByteBuffer* = NULL);
 
 	uint64_t ParamIntGetDef(int ID, uint64_t def = 0);
 
@@ -222,8 +257,10 @@ public:
 	void set_Peer(uint64_t rowid, const PeerID*);
 	bool get_Peer(uint64_t rowid, PeerID&);
 
+	// The block bodies and rollback data are kept in the BlockStore, the DB holds only their positions
 	void SetStateBlock(uint64_t rowid, const Blob& bodyP, const Blob& bodyE);
 	void GetStateBlock(uint64_t rowid, ByteBuffer* pP, ByteBuffer* pE, ByteBuffer* pRollback);
+	void GetStateBlock(uint64_t rowid, io::SharedBuffer* pP, io::SharedBuffer* pE); // zero-copy
 	void SetStateRollback(uint64_t rowid, const Blob& rollback);
 	//void DelStateBlockPRB(uint64_t rowid); // perishable and rollback, but no ethernal
 	void DelStateBlockAll(uint64_t rowid);
@@ -334,6 +371,15 @@ public:
 	void DeleteKernel(const Blob&, Height h);
 	Height FindKernel(const Blob&); // in case of duplicates - returning the one with the largest Height
 
+	struct KernelFilterStats
+	{
+		uint64_t m_Lookups = 0;
+		uint64_t m_Negatives = 0; // answered by the filter, no DB access
+		uint64_t m_FalsePositives = 0; // passed the filter, but not found in DB
+	};
+
+	const KernelFilterStats& get_KernelFilterStats() const { return m_KrnFilterStats; }
+
 	uint64_t FindStateWorkGreater(const Difficulty::Raw&);
 
 	// reset cursor to zero. Keep all the data: local macroblocks, peers, bbs, dummy UTXOs
@@ -341,15 +387,48 @@ public:
 
 private:
 
+	static const uint64_t s_Version = 14;
+
 	sqlite3* m_pDb;
 	sqlite3_stmt* m_pPrep[Query::count];
 
+	BlockStore m_BlockStore;
+	std::vector<uint32_t> m_vSegmentsUnused; // to be deleted once the transaction is committed
+	std::vector<uint32_t> m_vSegmentsReleased; // committed, to be deleted once the commit is durable
+	bool m_bWal = false;
+	uint8_t m_Synchronous = 2; // sqlite default
+
+	// Counting bloom filter in front of the Kernels index. Maintained by the writer connection only.
+	// Counters saturate (and stay so), hence no false negatives. Invalidated on rollback, rebuilt on demand.
+	struct KernelFilter
+	{
+		static const uint32_t s_Hashes = 4;
+		static const uint32_t s_CountersPerKrn = 12; // ~0.7% false positives at max load
+
+		std::vector<uint8_t> m_vCounters; // size is a power of 2
+		uint64_t m_Count = 0;
+		bool m_bEnabled = false;
+		bool m_bValid = false;
+
+		void Reset(uint64_t nCapacity);
+		void Add(const Blob&);
+		void Remove(const Blob&);
+		bool MayContain(const Blob&) const;
+		void get_Indexes(const Blob&, uint32_t*) const;
+	} m_KrnFilter;
+
+	KernelFilterStats m_KrnFilterStats;
+
+	void KernelFilterRebuild();
+
 	void TestRet(int);
 	void ThrowSqliteError(int);
 	static void ThrowError(const char*);
 	static void ThrowInconsistent();
 
 	void Create();
+	void SetProfile(const Profile&);
+	void TestVersion();
 	void ExecQuick(const char*);
 	bool ExecStep(sqlite3_stmt*);
 	bool ExecStep(Query::Enum, const char*); // returns true while there's a row
@@ -369,6 +448,16 @@ private:
 
 	void TestChanged1Row();
 
+	static bool get_BlockPos(Recordset&, int col, BlockStore::Pos&);
+	void BlockPut(const Blob&, BlockStore::Pos&);
+	void BlockRelease(const BlockStore::Pos&);
+	void ReleaseStateBlock(uint64_t rowid, bool bBody, bool bRollback);
+	void OnSegmentUnused(uint32_t);
+	void UnmapDeletedSegments();
+	void DeleteOrphanSegments(uint32_t iActive);
+	void OnCommitted();
+	bool IsCommitDurable();
+
 	struct Dmmr;
 };
 
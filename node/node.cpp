@@ -193,6 +193,86 @@ void Node::Wanted::OnTimer()
 	}
 }
 
+bool Node::ServeCache::Key::operator < (const Key& k) const
+{
+	if (m_ID < k.m_ID)
+		return true;
+	if (k.m_ID < m_ID)
+		return false;
+	if (m_Code != k.m_Code)
+		return (m_Code < k.m_Code);
+	return (m_Count < k.m_Count);
+}
+
+const Node::ServeCache::Item* Node::ServeCache::Find(const Key& key)
+{
+	if (!get_ParentObj().m_Cfg.m_ServeCacheSize)
+		return NULL;
+
+	Item n;
+	n.m_Key = key;
+
+	Set::iterator it = m_set.find(n);
+	if (m_set.end() == it)
+	{
+		m_Stats.m_Misses++;
+		return NULL;
+	}
+
+	m_Stats.m_Hits++;
+
+	// most recently used
+	Item& x = *it;
+	m_lst.erase(List::s_iterator_to(x));
+	m_lst.push_back(x);
+
+	return &x;
+}
+
+void Node::ServeCache::Add(const Key& key, const io::SharedBuffer& buf, const io::SharedBuffer& buf2)
+{
+	const uint32_t nMax = get_ParentObj().m_Cfg.m_ServeCacheSize;
+	if (buf.size + buf2.size > nMax)
+		return;
+
+	Item* pItem = new Item;
+	pItem->m_Key = key;
+	pItem->m_Buf = buf;
+	pItem->m_Buf2 = buf2;
+
+	if (!m_set.insert(*pItem).second)
+	{
+		// already cached
+		delete pItem;
+		return;
+	}
+
+	m_lst.push_back(*pItem);
+
+	m_Stats.m_Bytes += pItem->get_Size();
+	m_Stats.m_Items++;
+
+	while (m_Stats.m_Bytes > nMax)
+		Delete(m_lst.front());
+}
+
+void Node::ServeCache::Delete(Item& n)
+{
+	assert(m_Stats.m_Bytes >= n.get_Size());
+	m_Stats.m_Bytes -= n.get_Size();
+	m_Stats.m_Items--;
+
+	m_lst.erase(List::s_iterator_to(n));
+	m_set.erase(Set::s_iterator_to(n));
+	delete &n;
+}
+
+void Node::ServeCache::Clear()
+{
+	while (!m_lst.empty())
+		Delete(m_lst.back());
+}
+
 void Node::TryAssignTask(Task& t, const PeerID* pPeerID)
 {
 	if (pPeerID)
@@ -426,6 +506,7 @@ void Node::Processor::OnRolledBack()
 {
 	LOG_INFO() << "Rolled back to: " << m_Cursor.m_ID;
 	get_ParentObj().m_Compressor.OnRolledBack();
+	get_ParentObj().m_ServeCache.Clear();
 }
 
 bool Node::Processor::VerifyBlock(const Block::BodyBase& block, TxBase::IReader&& r, const HeightRange& hr)
@@ -433,7 +514,7 @@ bool Node::Processor::VerifyBlock(const Block::BodyBase& block, TxBase::IReader&
 	uint32_t nThreads = get_ParentObj().m_Cfg.m_VerificationThreads;
 	if (!nThreads)
 	{
-		std::unique_ptr<Verifier::MyBatch> p(new Verifier::MyBatch);
+		std::unique_ptr<Verifier::MyBatch> p(m_Verifier.CreateBatch());
 		p->m_bEnableBatch = true;
 		Verifier::MyBatch::Scope scope(*p);
 
@@ -442,17 +523,21 @@ bool Node::Processor::VerifyBlock(const Block::BodyBase& block, TxBase::IReader&
 			p->Flush();
 	}
 
+	VerifyBlockBegin(block, r, hr);
+	return VerifyBlockEnd(block, r, hr);
+}
+
+void Node::Processor::VerifyBlockBegin(const Block::BodyBase& block, TxBase::IReader& r, const HeightRange& hr)
+{
+	uint32_t nThreads = get_ParentObj().m_Cfg.m_VerificationThreads;
+	if (!nThreads)
+		return; // will be verified synchronously
+
 	Verifier& v = m_Verifier; // alias
 	std::unique_lock<std::mutex> scope(v.m_Mutex);
 
-	if (v.m_vThreads.empty())
-	{
-		v.m_iTask = 1;
-
-		v.m_vThreads.resize(nThreads);
-		for (uint32_t i = 0; i < nThreads; i++)
-			v.m_vThreads[i] = std::thread(&Verifier::Thread, &v, i);
-	}
+	v.InitThreads(nThreads);
+	assert(!v.m_Remaining);
 
 	v.m_Context.Reset();
 	v.m_iTask ^= 2;
@@ -462,24 +547,243 @@ bool Node::Processor::VerifyBlock(const Block::BodyBase& block, TxBase::IReader&
 	v.m_Remaining = nThreads;
 	v.m_Context.m_bBlockMode = true;
 	v.m_Context.m_Height = hr;
-	v.m_Context.m_nVerifiers = nThreads;
+	v.m_Context.m_pChunks = &v.m_Chunks;
+	v.m_Chunks.m_iNext = 0;
 
 	v.m_TaskNew.notify_all();
+}
+
+bool Node::Processor::VerifyBlockEnd(const Block::BodyBase& block, TxBase::IReader& r, const HeightRange& hr)
+{
+	if (!get_ParentObj().m_Cfg.m_VerificationThreads)
+		return NodeProcessor::VerifyBlockEnd(block, r, hr);
+
+	Verifier& v = m_Verifier; // alias
+	std::unique_lock<std::mutex> scope(v.m_Mutex);
 
 	while (v.m_Remaining)
 		v.m_TaskFinished.wait(scope);
 
+	// the subsidy flag is evaluated now, since it may have been changed by the interpretation of the previous block
 	return !v.m_bFail && v.m_Context.IsValidBlock(block, m_Extra.m_SubsidyOpen);
 }
 
+void Node::Processor::PrepareUtxoHash()
+{
+	uint32_t nThreads = get_ParentObj().m_Cfg.m_VerificationThreads;
+	if (!nThreads)
+		return;
+
+	UtxoTree::DirtyList vDirty;
+	get_Utxos().get_DirtySubtrees(vDirty, nThreads * 8); // finer granularity for better balancing
+	if (vDirty.size() < nThreads)
+		return; // not worth it
+
+	Verifier& v = m_Verifier; // alias
+	std::unique_lock<std::mutex> scope(v.m_Mutex);
+
+	if (v.m_Remaining)
+		return; // busy with the verification of the next block, the tree will be hashed in this thread
+
+	v.InitThreads(nThreads);
+
+	v.m_iTask ^= 2;
+	v.m_pDirty = &vDirty;
+	v.m_Remaining = nThreads;
+
+	v.m_TaskNew.notify_all();
+
+	while (v.m_Remaining)
+		v.m_TaskFinished.wait(scope);
+
+	v.m_pDirty = NULL;
+}
+
+uint32_t Node::Processor::VerifyPoW(const Block::SystemState::Full* pS, uint32_t n)
+{
+	uint32_t nThreads = get_ParentObj().m_Cfg.m_VerificationThreads;
+	if (!nThreads || (n < 2))
+		return NodeProcessor::VerifyPoW(pS, n);
+
+	Verifier& v = m_Verifier; // alias
+	std::unique_lock<std::mutex> scope(v.m_Mutex);
+
+	if (v.m_Remaining)
+		return NodeProcessor::VerifyPoW(pS, n); // busy
+
+	v.InitThreads(nThreads);
+
+	v.m_iTask ^= 2;
+	v.m_pHdrs = pS;
+	v.m_iHdrInvalid = n;
+	v.m_Chunks.m_iNext = 0;
+	v.m_Remaining = nThreads;
+
+	v.m_TaskNew.notify_all();
+
+	while (v.m_Remaining)
+		v.m_TaskFinished.wait(scope);
+
+	v.m_pHdrs = NULL;
+	return v.m_iHdrInvalid;
+}
+
+bool Node::Processor::IsValidPoW(const Block::SystemState::Full& s)
+{
+	const std::set<Height>& v = get_ParentObj().m_Cfg.m_TestMode.m_PoWInvalid;
+	if (v.end() != v.find(s.m_Height))
+		return false;
+
+	return NodeProcessor::IsValidPoW(s);
+}
+
+void Node::Processor::RecoverOutputs(RecoveredOutput* pRes, const Output* const* ppOuts, uint32_t nCount)
+{
+	const Keys& keys = get_ParentObj().m_Keys;
+	uint32_t nKeys = static_cast<uint32_t>(keys.m_vMonitored.size());
+
+	uint32_t nThreads = get_ParentObj().m_Cfg.m_VerificationThreads;
+	if (!nThreads || (nCount * nKeys < 2))
+		return NodeProcessor::RecoverOutputs(pRes, ppOuts, nCount);
+
+	std::vector<RecoveredOutput> vAttempts(nCount * nKeys);
+	std::unique_ptr<std::atomic<uint32_t>[]> pKeyFirst(new std::atomic<uint32_t>[nCount]);
+	for (uint32_t i = 0; i < nCount; i++)
+		pKeyFirst[i] = nKeys;
+
+	Verifier::Recovery rec;
+	rec.m_ppOuts = ppOuts;
+	rec.m_pAttempts = &vAttempts.front();
+	rec.m_pKeyFirst = pKeyFirst.get();
+	rec.m_nKeys = nKeys;
+	rec.m_nTotal = nCount * nKeys;
+
+	{
+		Verifier& v = m_Verifier; // alias
+		std::unique_lock<std::mutex> scope(v.m_Mutex);
+
+		// During the sync the verification of the next block is usually in progress. Queue behind it (its result stays until collected),
+		// otherwise the recovery would almost always run in this thread only
+		if (v.m_Remaining)
+		{
+			v.m_RecoveryStats.m_Queued++;
+
+			while (v.m_Remaining)
+				v.m_TaskFinished.wait(scope);
+		}
+
+		v.m_RecoveryStats.m_Parallel++;
+
+		v.InitThreads(nThreads);
+
+		v.m_iTask ^= 2;
+		v.m_pRecovery = &rec;
+		v.m_Chunks.m_iNext = 0;
+		v.m_Remaining = nThreads;
+
+		v.m_TaskNew.notify_all();
+
+		while (v.m_Remaining)
+			v.m_TaskFinished.wait(scope);
+
+		v.m_pRecovery = NULL;
+	}
+
+	// merge: the result doesn't depend on the order in which the pairs were processed
+	for (uint32_t i = 0; i < nCount; i++)
+	{
+		uint32_t iKey = pKeyFirst[i];
+		if (iKey < nKeys)
+			pRes[i] = vAttempts[i * nKeys + iKey];
+		else
+			pRes[i].m_Recovered = false;
+	}
+}
+
+void Node::Processor::Verifier::RecoverOutputs()
+{
+	const Keys& keys = get_ParentObj().get_ParentObj().m_Keys;
+	Recovery& rec = *m_pRecovery;
+
+	while (true)
+	{
+		uint32_t i = m_Chunks.Grab();
+		if (i >= rec.m_nTotal)
+			break;
+
+		uint32_t iOut = i / rec.m_nKeys;
+		uint32_t iKey = i % rec.m_nKeys;
+
+		std::atomic<uint32_t>& iKeyFirst = rec.m_pKeyFirst[iOut];
+		if (iKey > iKeyFirst)
+			continue; // already recovered by a preceding key
+
+		const Keys::Viewer& vw = keys.m_vMonitored[iKey];
+		RecoveredOutput& ro = rec.m_pAttempts[i];
+
+		if (!rec.m_ppOuts[iOut]->Recover(*vw.second, ro.m_Kidv))
+			continue;
+
+		ro.m_Recovered = true;
+		ro.m_iKdf = vw.first;
+
+		for (uint32_t iPrev = iKeyFirst; iKey < iPrev; )
+			if (iKeyFirst.compare_exchange_weak(iPrev, iKey))
+				break;
+	}
+}
+
+void Node::Processor::Verifier::VerifyHdrs()
+{
+	while (true)
+	{
+		// all the headers below the 1st invalid one must be verified, the rest may be skipped
+		uint32_t i = m_Chunks.Grab();
+		if (i >= m_iHdrInvalid)
+			break;
+
+		if (get_ParentObj().IsValidPoW(m_pHdrs[i]))
+			continue;
+
+		for (uint32_t iPrev = m_iHdrInvalid; i < iPrev; )
+			if (m_iHdrInvalid.compare_exchange_weak(iPrev, i))
+				break;
+	}
+}
+
+void Node::Processor::Verifier::InitThreads(uint32_t nThreads)
+{
+	if (!m_vThreads.empty())
+		return;
+
+	m_iTask = 1;
+
+	m_vThreads.resize(nThreads);
+	m_vStats.resize(nThreads);
+	for (uint32_t i = 0; i < nThreads; i++)
+		m_vThreads[i] = std::thread(&Verifier::Thread, this, i);
+}
+
+Node::Processor::Verifier::MyBatch* Node::Processor::Verifier::CreateBatch()
+{
+	const Config::VerificationBatch& cfg = get_ParentObj().get_ParentObj().m_Cfg.m_VerificationBatch;
+
+	uint32_t nProofsMax = std::min(cfg.m_MaxProofs, MyBatch::get_ProofsFor(cfg.m_MaxSize));
+	return new MyBatch(s_BatchProofsInitial, nProofsMax);
+}
+
 void Node::Processor::Verifier::Thread(uint32_t iVerifier)
 {
-	std::unique_ptr<Verifier::MyBatch> p(new Verifier::MyBatch);
+	std::unique_ptr<Verifier::MyBatch> p(CreateBatch());
 	p->m_bEnableBatch = true;
 	Verifier::MyBatch::Scope scope(*p);
 
 	for (uint32_t iTask = 1; ; )
 	{
+		const UtxoTree::DirtyList* pDirty;
+		const Block::SystemState::Full* pHdrs;
+		const Recovery* pRecovery;
+		std::chrono::steady_clock::time_point t0;
 		{
 			std::unique_lock<std::mutex> scope2(m_Mutex);
 
@@ -490,25 +794,66 @@ void Node::Processor::Verifier::Thread(uint32_t iVerifier)
 				return;
 
 			iTask = m_iTask;
+			pDirty = m_pDirty;
+			pHdrs = m_pHdrs;
+			pRecovery = m_pRecovery;
+			t0 = std::chrono::steady_clock::now();
+		}
+
+		if (pDirty || pHdrs || pRecovery)
+		{
+			if (pDirty)
+				get_ParentObj().get_Utxos().HashDirty(*pDirty, iVerifier, static_cast<uint32_t>(m_vThreads.size()));
+			else
+				if (pHdrs)
+					VerifyHdrs();
+				else
+					RecoverOutputs();
+
+			std::unique_lock<std::mutex> scope2(m_Mutex);
+			OnTaskDone(iVerifier, t0);
+
+			verify(m_Remaining--);
+			if (!m_Remaining)
+				m_TaskFinished.notify_one();
+
+			continue;
 		}
 
 		p->Reset();
+		p->m_nThreads = 1;
 
 		assert(m_Remaining);
 
 		TxBase::Context ctx;
 		ctx.m_bBlockMode = true;
 		ctx.m_Height = m_Context.m_Height;
-		ctx.m_nVerifiers = m_Context.m_nVerifiers;
-		ctx.m_iVerifier = iVerifier;
+		ctx.m_pChunks = m_Context.m_pChunks;
 		ctx.m_pAbort = &m_bFail; // obsolete actually
+		ctx.m_pPointCache = &get_ParentObj().m_PointCache;
 
 		TxBase::IReader::Ptr pR;
 		m_pR->Clone(pR);
 
-		bool bValid = ctx.ValidateAndSummarize(*m_pTx, std::move(*pR)) && p->Flush();
+		bool bValid = ctx.ValidateAndSummarize(*m_pTx, std::move(*pR));
+
+		p->Trim(); // don't keep the large buffer after a big block
+
+		if (bValid)
+		{
+			// The verifiers that are already done sit idle until this one finishes. The final batch evaluation spawns temporary
+			// threads (one per idle verifier) to use their cores, the idle verifiers themselves keep waiting for the next task.
+			{
+				std::unique_lock<std::mutex> scope2(m_Mutex);
+				p->m_nThreads = 1 + static_cast<uint32_t>(m_vThreads.size()) - m_Remaining;
+			}
+
+			bValid = p->Flush();
+		}
 
 		std::unique_lock<std::mutex> scope2(m_Mutex);
+		OnTaskDone(iVerifier, t0);
+		m_vStats[iVerifier].m_Elements += ctx.m_nVerified;
 
 		verify(m_Remaining--);
 
@@ -523,6 +868,32 @@ void Node::Processor::Verifier::Thread(uint32_t iVerifier)
 	}
 }
 
+void Node::Processor::Verifier::OnTaskDone(uint32_t iVerifier, const std::chrono::steady_clock::time_point& t0)
+{
+	VerifierStats& s = m_vStats[iVerifier];
+	s.m_Busy_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+	s.m_Tasks++;
+}
+
+void Node::OpenReadOnly(NodeDB& db) const
+{
+	db.OpenReadOnly(m_Cfg.m_sPathLocal.c_str());
+}
+
+void Node::get_VerifierStats(std::vector<VerifierStats>& v)
+{
+	Processor::Verifier& x = m_Processor.m_Verifier; // alias
+	std::unique_lock<std::mutex> scope(x.m_Mutex);
+	v = x.m_vStats;
+}
+
+void Node::get_RecoveryStats(RecoveryStats& s)
+{
+	Processor::Verifier& x = m_Processor.m_Verifier; // alias
+	std::unique_lock<std::mutex> scope(x.m_Mutex);
+	s = x.m_RecoveryStats;
+}
+
 bool Node::Processor::ApproveState(const Block::SystemState::ID& id)
 {
 	const Block::SystemState::ID& idCtl = get_ParentObj().m_Cfg.m_ControlState;
@@ -571,6 +942,13 @@ void Node::Processor::OnUpToDate()
 	ReportProgress();
 }
 
+void Node::Processor::OnMacroblockProgress(uint32_t nDone, uint32_t nTotal)
+{
+	auto observer = get_ParentObj().m_Cfg.m_Observer;
+	if (observer)
+		observer->OnSyncProgress(nDone, nTotal);
+}
+
 bool Node::Processor::OpenMacroblock(Block::BodyBase::RW& rw, const NodeDB::StateID& sid)
 {
 	get_ParentObj().m_Compressor.FmtPath(rw, sid.m_Height, NULL);
@@ -698,7 +1076,9 @@ void Node::Initialize(IExternalPOW* externalPOW)
 	}
 
 	m_Processor.m_Horizon = m_Cfg.m_Horizon;
-	m_Processor.Initialize(m_Cfg.m_sPathLocal.c_str(), m_Cfg.m_Sync.m_ForceResync);
+	m_Processor.m_UtxoSnapshotPeriod = m_Cfg.m_UtxoSnapshotPeriod;
+	m_Processor.m_PointCache.Resize(m_Cfg.m_PointCacheSize);
+	m_Processor.Initialize(m_Cfg.m_sPathLocal.c_str(), m_Cfg.m_Sync.m_ForceResync, &m_Cfg.m_DbProfile);
 
 	if (m_Cfg.m_Sync.m_ForceResync)
 		m_Processor.get_DB().ParamSet(NodeDB::ParamID::SyncTarget, NULL, NULL);
@@ -727,6 +1107,7 @@ void Node::Initialize(IExternalPOW* externalPOW)
 
 	m_PeerMan.Initialize();
 	m_Miner.Initialize(externalPOW);
+	m_TxValidator.Initialize();
 	m_Compressor.Init();
 	m_Bbs.Cleanup();
 }
@@ -891,6 +1272,8 @@ Node::~Node()
 
 	assert(m_setTasks.empty());
 
+	m_TxValidator.Stop();
+
 	Processor::Verifier& v = m_Processor.m_Verifier; // alias
 	if (!v.m_vThreads.empty())
 	{
@@ -1215,6 +1598,7 @@ void Node::Peer::DeleteSelf(bool bIsError, uint8_t nByeReason)
 
 	ReleaseTasks();
 	Unsubscribe();
+	m_This.m_TxValidator.OnPeerDeleted(*this);
 
 	if (m_pInfo)
 	{
@@ -1607,11 +1991,23 @@ void Node::Peer::OnMsg(proto::GetHdrPack&& msg)
 {
 	proto::HdrPack msgOut;
 
+	ServeCache::Key key;
+	key.m_ID = msg.m_Top;
+	key.m_Code = proto::HdrPack::s_Code;
+	key.m_Count = msg.m_Count;
+
 	if (msg.m_Count)
 	{
 		if (msg.m_Count > proto::g_HdrPackMaxSize)
 			ThrowUnexpected();
 
+		const ServeCache::Item* pItem = m_This.m_ServeCache.Find(key);
+		if (pItem)
+		{
+			SendSerialized(proto::HdrPack::s_Code, pItem->m_Buf);
+			return;
+		}
+
 		NodeDB& db = m_This.m_Processor.get_DB();
 		uint64_t rowid = db.StateFindSafe(msg.m_Top);
 		if (rowid)
@@ -1638,7 +2034,21 @@ void Node::Peer::OnMsg(proto::GetHdrPack&& msg)
 	if (msgOut.m_vElements.empty())
 		Send(proto::DataMissing(Zero));
 	else
-		Send(msgOut);
+	{
+		if (m_This.m_Cfg.m_ServeCacheSize)
+		{
+			Serializer ser;
+			ser & msgOut;
+
+			SerializeBuffer sb = ser.buffer();
+			io::SharedBuffer buf(sb.first, sb.second);
+			m_This.m_ServeCache.Add(key, buf);
+
+			SendSerialized(proto::HdrPack::s_Code, buf);
+		}
+		else
+			Send(msgOut);
+	}
 }
 
 void Node::Peer::OnMsg(proto::HdrPack&& msg)
@@ -1651,40 +2061,33 @@ void Node::Peer::OnMsg(proto::HdrPack&& msg)
 	if (msg.m_vElements.empty() || (msg.m_vElements.size() > proto::g_HdrPackMaxSize))
 		ThrowUnexpected();
 
-	Block::SystemState::Full s;
-	Cast::Down<Block::SystemState::Sequence::Prefix>(s) = msg.m_Prefix;
-	Cast::Down<Block::SystemState::Sequence::Element>(s) = msg.m_vElements.back();
+	uint32_t nStates = static_cast<uint32_t>(msg.m_vElements.size());
+	std::vector<Block::SystemState::Full> vStates(nStates);
 
-	uint32_t nAccepted = 0;
-	bool bInvalid = false;
+	Block::SystemState::Full& s0 = vStates.front();
+	Cast::Down<Block::SystemState::Sequence::Prefix>(s0) = msg.m_Prefix;
+	Cast::Down<Block::SystemState::Sequence::Element>(s0) = msg.m_vElements.back();
 
-	for (size_t i = msg.m_vElements.size(); ; )
+	for (uint32_t i = 1; i < nStates; i++)
 	{
-		NodeProcessor::DataStatus::Enum eStatus = m_This.m_Processor.OnState(s, m_pInfo->m_ID.m_Key);
-		switch (eStatus)
-		{
-		case NodeProcessor::DataStatus::Invalid:
-			bInvalid = true;
-			break;
-
-		case NodeProcessor::DataStatus::Accepted:
-			nAccepted++;
-
-		default:
-			break; // suppress warning
-		}
-
-		if (! --i)
-			break;
+		Block::SystemState::Full& s = vStates[i];
+		s = vStates[i - 1];
 
 		s.NextPrefix();
-		Cast::Down<Block::SystemState::Sequence::Element>(s) = msg.m_vElements[i - 1];
+		Cast::Down<Block::SystemState::Sequence::Element>(s) = msg.m_vElements[nStates - 1 - i];
 		s.m_ChainWork += s.m_PoW.m_Difficulty;
 	}
 
+	uint32_t nAccepted = 0;
+	uint32_t iInvalid = m_This.m_Processor.OnStates(&vStates.front(), nStates, m_pInfo->m_ID.m_Key, nAccepted);
+	bool bInvalid = (iInvalid < nStates);
+
+	if (bInvalid)
+		LOG_WARNING() << "Peer " << m_RemoteAddr << " Invalid header " << iInvalid << " of " << nStates << " in the pack";
+
 	// just to be pedantic
 	Block::SystemState::ID id;
-	s.get_ID(id);
+	vStates.back().get_ID(id);
 	if (id != t.m_Key.first)
 		bInvalid = true;
 
@@ -1704,15 +2107,33 @@ void Node::Peer::OnMsg(proto::HdrPack&& msg)
 
 void Node::Peer::OnMsg(proto::GetBody&& msg)
 {
+	ServeCache::Key key;
+	key.m_ID = msg.m_ID;
+	key.m_Code = proto::Body::s_Code;
+	key.m_Count = 0;
+
+	const ServeCache::Item* pItem = m_This.m_ServeCache.Find(key);
+	if (pItem)
+	{
+		SendBody(pItem->m_Buf, pItem->m_Buf2);
+		return;
+	}
+
 	uint64_t rowid = m_This.m_Processor.get_DB().StateFindSafe(msg.m_ID);
 	if (rowid)
 	{
-		proto::Body msgBody;
-		m_This.m_Processor.get_DB().GetStateBlock(rowid, &msgBody.m_Perishable, &msgBody.m_Eternal, NULL);
+		io::SharedBuffer bufP, bufE;
+		m_This.m_Processor.get_DB().GetStateBlock(rowid, &bufP, &bufE);
 
-		if (!msgBody.m_Perishable.empty())
+		if (!bufP.empty())
 		{
-			Send(msgBody);
+			SendBody(bufP, bufE); // references the block store directly
+
+			if (m_This.m_Cfg.m_ServeCacheSize)
+			{
+				// copy. Referencing the mapped buffers would pin the whole segment mapping per item, not accounted in the cache size
+				m_This.m_ServeCache.Add(key, io::SharedBuffer(bufP.data, bufP.size), io::SharedBuffer(bufE.data, bufE.size));
+			}
 			return;
 		}
 
@@ -1757,7 +2178,12 @@ void Node::Peer::OnMsg(proto::NewTransaction&& msg)
 	// However the transaction body must have already been checked for NULLs
 
 	if (msg.m_Fluff)
-		m_This.OnTransactionFluff(std::move(msg.m_Transaction), this, NULL);
+	{
+		// duplicates are dropped before the (costly) validation
+		Transaction::KeyType key;
+		if (m_This.OnTransactionFluffPre(*msg.m_Transaction, key) && !m_This.m_TxValidator.Push(msg.m_Transaction, key, *this))
+			m_This.OnTransactionFluff(std::move(msg.m_Transaction), this, NULL);
+	}
 	else
 	{
 		proto::Boolean msgOut;
@@ -1768,11 +2194,244 @@ void Node::Peer::OnMsg(proto::NewTransaction&& msg)
 
 bool Node::ValidateTx(Transaction::Context& ctx, const Transaction& tx)
 {
+	// range proofs and kernel signatures are verified in a single batch
+	typedef ECC::InnerProduct::BatchContextEx<4> MyBatch;
+
+	std::unique_ptr<MyBatch> p(new MyBatch);
+	p->m_bEnableBatch = true;
+	MyBatch::Scope scope(*p);
+
+	ctx.m_pPointCache = &m_Processor.m_PointCache;
+
 	return
 		tx.IsValid(ctx) &&
+		p->Flush() &&
 		m_Processor.ValidateTxContext(tx);
 }
 
+void Node::TxValidator::Initialize()
+{
+	uint32_t nThreads = get_ParentObj().m_Cfg.m_VerificationThreads;
+	if (!nThreads)
+		return;
+
+	m_pEvtDone = io::AsyncEvent::create(io::Reactor::get_Current(), [this]() { OnDone(); });
+
+	m_vThreads.resize(nThreads);
+	for (uint32_t i = 0; i < nThreads; i++)
+		m_vThreads[i] = std::thread(&TxValidator::Thread, this);
+}
+
+void Node::TxValidator::Stop()
+{
+	if (m_vThreads.empty())
+		return;
+
+	{
+		std::unique_lock<std::mutex> scope(m_Mutex);
+		m_bStop = true;
+		m_NewItem.notify_all();
+	}
+
+	for (size_t i = 0; i < m_vThreads.size(); i++)
+		if (m_vThreads[i].joinable())
+			m_vThreads[i].join();
+
+	m_vThreads.clear();
+
+	// all the peers must have been deleted already
+	assert(m_queuePeers.empty() && m_lstInProgress.empty());
+	DeleteAll(m_lstDone);
+}
+
+void Node::TxValidator::DeleteAll(ItemList& lst)
+{
+	while (!lst.empty())
+	{
+		Item& x = lst.front();
+		lst.pop_front();
+		delete &x;
+	}
+}
+
+bool Node::TxValidator::Push(Transaction::Ptr& pTx, const Transaction::KeyType& key, Peer& peer)
+{
+	if (m_vThreads.empty())
+		return false;
+
+	const Config::TxValidation& cfg = get_ParentObj().m_Cfg.m_TxValidation;
+
+	std::unique_lock<std::mutex> scope(m_Mutex);
+
+	if ((m_Total >= cfg.m_MaxPending) || (peer.m_TxPending.m_lst.size() >= cfg.m_MaxPendingPerPeer))
+	{
+		// report once, the total is logged when the queue is drained
+		if (!m_Dropped++)
+			LOG_WARNING() << "Tx validation queue is full, dropping txs";
+		return true;
+	}
+
+	m_setPending.insert(key);
+
+	Item* pItem = new Item;
+	pItem->m_pTx = std::move(pTx);
+	pItem->m_Key = key;
+	pItem->m_pPeer = &peer;
+	pItem->m_bValid = false;
+	pItem->m_Context.m_pPointCache = &get_ParentObj().m_Processor.m_PointCache;
+
+	if (peer.m_TxPending.m_lst.empty())
+		m_queuePeers.push_back(peer.m_TxPending);
+
+	peer.m_TxPending.m_lst.push_back(*pItem);
+	m_Total++;
+
+	m_NewItem.notify_one();
+	return true;
+}
+
+void Node::TxValidator::OnPeerDeleted(Peer& peer)
+{
+	if (m_vThreads.empty())
+		return;
+
+	std::unique_lock<std::mutex> scope(m_Mutex);
+
+	if (!peer.m_TxPending.m_lst.empty())
+	{
+		m_Total -= static_cast<uint32_t>(peer.m_TxPending.m_lst.size());
+
+		for (ItemList::iterator it = peer.m_TxPending.m_lst.begin(); peer.m_TxPending.m_lst.end() != it; it++)
+			m_setPending.erase(it->m_Key);
+
+		DeleteAll(peer.m_TxPending.m_lst);
+		m_queuePeers.erase(PeerQueue::s_iterator_to(peer.m_TxPending));
+	}
+
+	for (ItemList::iterator it = m_lstInProgress.begin(); m_lstInProgress.end() != it; it++)
+		if (&peer == it->m_pPeer)
+			it->m_pPeer = NULL;
+
+	for (ItemList::iterator it = m_lstDone.begin(); m_lstDone.end() != it; it++)
+		if (&peer == it->m_pPeer)
+			it->m_pPeer = NULL;
+}
+
+void Node::TxValidator::Thread()
+{
+	std::unique_ptr<MyBatch> p(new MyBatch);
+	p->m_bEnableBatch = true;
+	MyBatch::Scope scope(*p);
+
+	MyBatch::Journal jrnl;
+	p->m_pJournal = &jrnl;
+
+	Item* pItems[s_TxsPerBatch];
+	uint32_t pEqEnd[s_TxsPerBatch];
+
+	while (true)
+	{
+		uint32_t nItems = 0;
+		{
+			std::unique_lock<std::mutex> scope2(m_Mutex);
+
+			while (m_queuePeers.empty() && !m_bStop)
+				m_NewItem.wait(scope2);
+
+			if (m_bStop)
+				return;
+
+			do
+			{
+				// take one item of the 1st peer, and move it to the end of the queue
+				PerPeer& pp = m_queuePeers.front();
+				m_queuePeers.pop_front();
+
+				Item* pItem = &pp.m_lst.front();
+				pp.m_lst.pop_front();
+
+				if (!pp.m_lst.empty())
+					m_queuePeers.push_back(pp);
+
+				m_lstInProgress.push_back(*pItem);
+				pItems[nItems++] = pItem;
+
+			} while ((nItems < s_TxsPerBatch) && !m_queuePeers.empty());
+		}
+
+		p->Reset();
+		jrnl.Reset();
+
+		for (uint32_t i = 0; i < nItems; i++)
+		{
+			Item& item = *pItems[i];
+			item.m_bValid = item.m_pTx->IsValid(item.m_Context);
+			pEqEnd[i] = jrnl.m_iEquation;
+		}
+
+		if (!p->Flush())
+		{
+			// attribute the invalid equations to their transactions
+			uint32_t iItem = 0;
+			for (size_t j = 0; j < jrnl.m_vInvalid.size(); j++)
+			{
+				uint32_t iEq = jrnl.m_vInvalid[j];
+				while (pEqEnd[iItem] <= iEq)
+					iItem++;
+
+				assert(iItem < nItems);
+				pItems[iItem]->m_bValid = false;
+			}
+		}
+
+		{
+			std::unique_lock<std::mutex> scope2(m_Mutex);
+
+			for (uint32_t i = 0; i < nItems; i++)
+			{
+				m_lstInProgress.erase(ItemList::s_iterator_to(*pItems[i]));
+				m_lstDone.push_back(*pItems[i]);
+			}
+		}
+
+		m_pEvtDone->post();
+	}
+}
+
+void Node::TxValidator::OnDone()
+{
+	ItemList lst;
+	{
+		std::unique_lock<std::mutex> scope(m_Mutex);
+		lst.splice(lst.end(), m_lstDone);
+		m_Total -= static_cast<uint32_t>(lst.size());
+	}
+
+	Node& n = get_ParentObj();
+
+	if (m_Dropped && (m_Total < n.m_Cfg.m_TxValidation.m_MaxPending))
+	{
+		LOG_WARNING() << "Tx validation queue: " << m_Dropped << " txs were dropped";
+		m_Dropped = 0;
+	}
+
+	while (!lst.empty())
+	{
+		std::unique_ptr<Item> pItem(&lst.front());
+		lst.pop_front();
+
+		m_setPending.erase(pItem->m_Key);
+
+		if (pItem->m_bValid)
+			n.OnTransactionFluff(std::move(pItem->m_pTx), pItem->m_pPeer, NULL, &pItem->m_Context);
+		else
+		{
+			n.m_Wtx.Delete(pItem->m_Key);
+			n.LogTx(*pItem->m_pTx, false, pItem->m_Key);
+		}
+	}
+}
+
 void Node::LogTx(const Transaction& tx, bool bValid, const Transaction::KeyType& key)
 {
 	std::ostringstream os;
@@ -2117,30 +2776,22 @@ void Node::AddDummyOutputs(Transaction& tx)
 	}
 }
 
-bool Node::OnTransactionFluff(Transaction::Ptr&& ptxArg, const Peer* pPeer, TxPool::Stem::Element* pElem)
+bool Node::OnTransactionFluff(Transaction::Ptr&& ptxArg, const Peer* pPeer, TxPool::Stem::Element* pElem, const Transaction::Context* pCtxFree)
 {
 	Transaction::Ptr ptx;
 	ptx.swap(ptxArg);
 
 	Transaction::Context ctx;
+	if (pCtxFree)
+		ctx = *pCtxFree;
+
 	if (pElem)
 	{
 		ctx.m_Fee = pElem->m_Profit.m_Fee;
 		m_Dandelion.Delete(*pElem);
 	}
 	else
-	{
-		for (size_t i = 0; i < ptx->m_vKernels.size(); i++)
-		{
-			TxPool::Stem::Element::Kernel key;
-			ptx->m_vKernels[i]->get_ID(key.m_hv);
-
-			TxPool::Stem::KrnSet::iterator it = m_Dandelion.m_setKrns.find(key);
-			if (m_Dandelion.m_setKrns.end() != it)
-				m_Dandelion.Delete(*it->m_pThis);
-		}
-
-	}
+		DeleteStemsByKernels(*ptx);
 
 	TxPool::Fluff::Element::Tx key;
 	ptx->get_Key(key.m_Key);
@@ -2154,7 +2805,10 @@ bool Node::OnTransactionFluff(Transaction::Ptr&& ptxArg, const Peer* pPeer, TxPo
 	m_Wtx.Delete(key.m_Key);
 
 	// new transaction
-	bool bValid = pElem ? true: ValidateTx(ctx, tx);
+	bool bValid =
+		pElem ? true :
+		pCtxFree ? m_Processor.ValidateTxContext(tx) :
+		ValidateTx(ctx, tx);
 	LogTx(tx, bValid, key.m_Key);
 
 	if (!bValid)
@@ -2183,6 +2837,35 @@ bool Node::OnTransactionFluff(Transaction::Ptr&& ptxArg, const Peer* pPeer, TxPo
 	return true;
 }
 
+bool Node::OnTransactionFluffPre(const Transaction& tx, Transaction::KeyType& key)
+{
+	DeleteStemsByKernels(tx);
+
+	tx.get_Key(key);
+
+	TxPool::Fluff::Element::Tx keyFluff;
+	keyFluff.m_Key = key;
+
+	if ((m_TxPool.m_setTxs.end() != m_TxPool.m_setTxs.find(keyFluff)) || m_TxValidator.IsPending(key))
+		return false;
+
+	m_Wtx.Delete(key);
+	return true;
+}
+
+void Node::DeleteStemsByKernels(const Transaction& tx)
+{
+	for (size_t i = 0; i < tx.m_vKernels.size(); i++)
+	{
+		TxPool::Stem::Element::Kernel key;
+		tx.m_vKernels[i]->get_ID(key.m_hv);
+
+		TxPool::Stem::KrnSet::iterator it = m_Dandelion.m_setKrns.find(key);
+		if (m_Dandelion.m_setKrns.end() != it)
+			m_Dandelion.Delete(*it->m_pThis);
+	}
+}
+
 void Node::Dandelion::OnTimedOut(Element& x)
 {
 	if (x.m_bAggregating)
@@ -2643,6 +3326,7 @@ void Node::Peer::OnMsg(proto::MacroblockGet&& msg)
 		ThrowUnexpected();
 
 	proto::Macroblock msgOut;
+	io::SharedBuffer bufPortion;
 
 	if (m_This.m_Cfg.m_HistoryCompression.m_UploadPortion)
 	{
@@ -2668,20 +3352,24 @@ void Node::Peer::OnMsg(proto::MacroblockGet&& msg)
 				std::string sPath;
 				rw.GetPath(sPath, msg.m_Data);
 
-				std::FStream fs;
-				if (fs.Open(sPath.c_str(), true) && (fs.get_Remaining() > msg.m_Offset))
+				try {
+					// the portion is sent directly from the mapped file
+					bufPortion = io::map_file_read_only(sPath.c_str());
+				} catch (const std::exception&) {
+				}
+
+				if (bufPortion.size > msg.m_Offset)
 				{
-					uint64_t nDelta = fs.get_Remaining() - msg.m_Offset;
+					uint64_t nDelta = bufPortion.size - msg.m_Offset;
 
 					uint32_t nPortion = m_This.m_Cfg.m_HistoryCompression.m_UploadPortion;
 					if (nPortion > nDelta)
 						nPortion = (uint32_t)nDelta;
 
-					fs.Seek(msg.m_Offset);
-
-					msgOut.m_Portion.resize(nPortion);
-					fs.read(&msgOut.m_Portion.at(0), nPortion);
+					bufPortion.assign(bufPortion.data + msg.m_Offset, nPortion, bufPortion.guard);
 				}
+				else
+					bufPortion.clear();
 			}
 
 			msgOut.m_ID = id;
@@ -2690,7 +3378,7 @@ void Node::Peer::OnMsg(proto::MacroblockGet&& msg)
 		}
 	}
 
-	Send(msgOut);
+	SendMacroblock(msgOut.m_ID, bufPortion, msgOut.m_SizeTotal);
 }
 
 void Node::Peer::OnMsg(proto::GetUtxoEvents&& msg)
@@ -3016,10 +3704,16 @@ bool Node::Miner::Restart()
 			return false; // wait until we receive that outdated finalization
 	}
 	else
+	{
 		if (!keys.m_pMiner)
 			return false; // offline mining is disabled
 
+		if (IsCurrentTaskUpToDate())
+			return true; // keep mining it
+	}
+
 	NodeProcessor::BlockContext bc(get_ParentObj().m_TxPool, keys.m_pMiner ? *keys.m_pMiner : *keys.m_pGeneric);
+	bc.m_pTemplate = &m_Template;
 	if (m_pFinalizer)
 		bc.m_Mode = NodeProcessor::BlockContext::Mode::Assemble;
 
@@ -3070,6 +3764,20 @@ bool Node::Miner::Restart()
 	return true;
 }
 
+bool Node::Miner::IsCurrentTaskUpToDate()
+{
+	const Block::SystemState::ID& tip = get_ParentObj().m_Processor.m_Cursor.m_ID;
+	if (!(m_Template.m_Tip == tip) || m_Template.HasUntried(get_ParentObj().m_TxPool))
+		return false;
+
+	std::scoped_lock<std::mutex> scope(m_Mutex);
+	return
+		m_pTask &&
+		!*m_pTask->m_pStop &&
+		(m_pTask->m_Hdr.m_Height == tip.m_Height + 1) &&
+		(m_pTask->m_Hdr.m_Prev == tip.m_Hash);
+}
+
 void Node::Miner::StartMining(Task::Ptr&& pTask)
 {
 	assert(pTask && !m_pTaskToFinalize);
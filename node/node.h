@@ -22,6 +22,7 @@
 #include <boost/intrusive/list.hpp>
 #include <boost/intrusive/set.hpp>
 #include <condition_variable>
+#include <chrono>
 
 namespace beam
 {
@@ -43,7 +44,9 @@ struct Node
 		std::vector<io::Address> m_Connect;
 
 		std::string m_sPathLocal;
+		NodeDB::Profile m_DbProfile;
 		NodeProcessor::Horizon m_Horizon;
+		Height m_UtxoSnapshotPeriod = 1440; // persist the UTXO set each N blocks to speed-up startup. 0 - disabled
 
 #if defined(BEAM_USE_GPU)
 		bool m_UseGpu;
@@ -67,12 +70,27 @@ struct Node
 		uint32_t m_BbsIdealChannelPopulation = 100;
 		uint32_t m_MaxPoolTransactions = 100 * 1000;
 		uint32_t m_MiningThreads = 0; // by default disabled
+		uint32_t m_ServeCacheSize = 32 * 1024 * 1024; // bytes, for the blocks and headers recently served to peers. 0 - disabled
+		uint32_t m_PointCacheSize = 8 * 1024 * 1024; // bytes, decompressed commitments of the recently validated outputs, saves the decompression of their inputs. 0 - disabled
 
-		// Number of verification threads for CPU-hungry cryptography. Currently used for block validation only.
+		// Number of verification threads for CPU-hungry cryptography. Used for block validation, and context-free validation of the incoming transactions.
 		// 0: single threaded
 		// negative: number of cores minus number of mining threads.
 		int m_VerificationThreads = 0;
 
+		struct VerificationBatch {
+			// The batch of each block verifier starts small and grows with the number of proofs up to the limit (larger batches are faster per proof),
+			// and is trimmed back when the subsequent blocks are small. Roughly 36KB per proof
+			uint32_t m_MaxProofs = 400;
+			uint32_t m_MaxSize = 16 * 1024 * 1024; // bytes, fixed memory budget per verification thread (not derived from the CPU cache size)
+		} m_VerificationBatch;
+
+		struct TxValidation {
+			// bounds for the incoming transactions, awaiting the context-free validation (when verification threads are used)
+			uint32_t m_MaxPending = 1000;
+			uint32_t m_MaxPendingPerPeer = 100;
+		} m_TxValidation;
+
 		struct HistoryCompression
 		{
 			std::string m_sPathOutput;
@@ -88,6 +106,7 @@ struct Node
 		struct TestMode {
 			// for testing only!
 			uint32_t m_FakePowSolveTime_ms = 15 * 1000;
+			std::set<Height> m_PoWInvalid; // the PoW of the headers at those heights is considered invalid
 
 		} m_TestMode;
 
@@ -156,6 +175,39 @@ struct Node
 
 	NodeProcessor& get_Processor() { return m_Processor; } // for tests only!
 
+	// Secondary connection for the readers that may run concurrently with the node (e.g. explorer). Sees only the committed (flushed) data
+	void OpenReadOnly(NodeDB&) const;
+
+	struct VerifierStats
+	{
+		uint64_t m_Busy_us = 0; // total time spent on the verification tasks
+		uint32_t m_Tasks = 0;
+		uint64_t m_Elements = 0; // block elements (inputs, outputs, kernels, offset) verified by this thread
+	};
+
+	void get_VerifierStats(std::vector<VerifierStats>&); // per verification thread
+
+	struct RecoveryStats
+	{
+		// batches of outputs recovered with the monitored keys on the verification threads
+		uint32_t m_Parallel = 0;
+		uint32_t m_Queued = 0; // of them, waited for the verification of the next block (during the sync)
+	};
+
+	void get_RecoveryStats(RecoveryStats&);
+
+	struct ServeCacheStats
+	{
+		uint64_t m_Hits = 0;
+		uint64_t m_Misses = 0;
+		uint64_t m_Bytes = 0; // currently cached
+		uint32_t m_Items = 0;
+	};
+
+	const ServeCacheStats& get_ServeCacheStats() const { return m_ServeCache.m_Stats; }
+
+	void get_PointCacheStats(ECC::PointCache::Stats& s) const { m_Processor.m_PointCache.get_Stats(s); }
+
 private:
 
 	struct Processor
@@ -167,37 +219,71 @@ private:
 		void OnNewState() override;
 		void OnRolledBack() override;
 		bool VerifyBlock(const Block::BodyBase&, TxBase::IReader&&, const HeightRange&) override;
+		void VerifyBlockBegin(const Block::BodyBase&, TxBase::IReader&, const HeightRange&) override;
+		bool VerifyBlockEnd(const Block::BodyBase&, TxBase::IReader&, const HeightRange&) override;
 		bool ApproveState(const Block::SystemState::ID&) override;
 		void AdjustFossilEnd(Height&) override;
 		void OnStateData() override;
 		void OnBlockData() override;
 		void OnUpToDate() override;
+		void OnMacroblockProgress(uint32_t nDone, uint32_t nTotal) override;
 		bool OpenMacroblock(Block::BodyBase::RW&, const NodeDB::StateID&) override;
 		void OnModified() override;
 		bool EnumViewerKeys(IKeyWalker&) override;
+		void PrepareUtxoHash() override;
+		uint32_t VerifyPoW(const Block::SystemState::Full*, uint32_t n) override;
+		bool IsValidPoW(const Block::SystemState::Full&) override;
+		void RecoverOutputs(RecoveredOutput*, const Output* const*, uint32_t nCount) override;
 
 		void ReportProgress();
 		void ReportNewState();
 
 		struct Verifier
 		{
-			typedef ECC::InnerProduct::BatchContextEx<100> MyBatch; // seems to be ok, for larger batches difference is marginal
+			typedef ECC::InnerProduct::BatchContextHeap MyBatch;
+			static const uint32_t s_BatchProofsInitial = 8;
+			MyBatch* CreateBatch(); // sized according to the config
 
 			const TxBase* m_pTx;
 			TxBase::IReader* m_pR;
 			TxBase::Context m_Context;
+			TxBase::Context::Chunks m_Chunks;
+
+			const UtxoTree::DirtyList* m_pDirty = NULL; // if set - rehash task instead of the block verification
+
+			// if set - PoW verification of the headers. The headers are grabbed via m_Chunks, one by one
+			const Block::SystemState::Full* m_pHdrs = NULL;
+			std::atomic<uint32_t> m_iHdrInvalid;
+			void VerifyHdrs();
+
+			// if set - recovery of the outputs with the monitored keys. The (output, key) pairs are grabbed via m_Chunks, one by one
+			struct Recovery
+			{
+				const Output* const* m_ppOuts;
+				RecoveredOutput* m_pAttempts; // per (output, key) pair
+				std::atomic<uint32_t>* m_pKeyFirst; // per output, the 1st key that fits so far
+				uint32_t m_nKeys;
+				uint32_t m_nTotal;
+			};
+
+			Recovery* m_pRecovery = NULL;
+			void RecoverOutputs();
+			RecoveryStats m_RecoveryStats; // protected by m_Mutex
 
 			bool m_bFail;
 			uint32_t m_iTask;
-			uint32_t m_Remaining;
+			uint32_t m_Remaining = 0;
 
 			std::mutex m_Mutex;
 			std::condition_variable m_TaskNew;
 			std::condition_variable m_TaskFinished;
 
 			std::vector<std::thread> m_vThreads;
+			std::vector<VerifierStats> m_vStats; // protected by m_Mutex
 
 			void Thread(uint32_t);
+			void InitThreads(uint32_t nThreads); // assuming the mutex is locked
+			void OnTaskDone(uint32_t iVerifier, const std::chrono::steady_clock::time_point&); // assuming the mutex is locked
 
 			IMPLEMENT_GET_PARENT_OBJ(Processor, m_Verifier)
 		} m_Verifier;
@@ -339,12 +425,113 @@ private:
 		IMPLEMENT_GET_PARENT_OBJ(Node, m_Dandelion)
 	} m_Dandelion;
 
+	struct TxValidator
+	{
+		// Context-free validation of the incoming fluff transactions is performed by the worker threads.
+		// Peers are served in round-robin manner, the results are handled in the reactor thread.
+		// Several transactions are verified in a single batch, in case of failure the invalid ones are identified by the batch journal.
+		typedef ECC::InnerProduct::BatchContextEx<4> MyBatch;
+		static const uint32_t s_TxsPerBatch = 8;
+
+		struct Item
+			:public boost::intrusive::list_base_hook<>
+		{
+			Transaction::Ptr m_pTx;
+			Transaction::KeyType m_Key;
+			Transaction::Context m_Context;
+			Peer* m_pPeer; // reset if the peer is deleted in the meanwhile
+			bool m_bValid;
+		};
+
+		typedef boost::intrusive::list<Item> ItemList;
+
+		struct PerPeer
+			:public boost::intrusive::list_base_hook<>
+		{
+			ItemList m_lst;
+		};
+
+		typedef boost::intrusive::list<PerPeer> PeerQueue;
+
+		PeerQueue m_queuePeers; // peers with pending items
+		ItemList m_lstInProgress;
+		ItemList m_lstDone;
+		uint32_t m_Total = 0; // including those in progress and done
+
+		std::set<Transaction::KeyType> m_setPending; // keys of all the pushed txs, accessed only by the reactor thread
+		uint32_t m_Dropped = 0; // since the queue became full
+
+		bool m_bStop = false;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_NewItem;
+		std::vector<std::thread> m_vThreads;
+		io::AsyncEvent::Ptr m_pEvtDone;
+
+		void Initialize();
+		void Stop();
+		bool Push(Transaction::Ptr&, const Transaction::KeyType&, Peer&); // returns false if the validation should be done synchronously
+		bool IsPending(const Transaction::KeyType& key) const { return m_setPending.end() != m_setPending.find(key); }
+		void OnPeerDeleted(Peer&);
+
+		void Thread();
+		void OnDone();
+
+		static void DeleteAll(ItemList&);
+
+		IMPLEMENT_GET_PARENT_OBJ(Node, m_TxValidator)
+	} m_TxValidator;
+
+	struct ServeCache
+	{
+		// Serialized HdrPack messages, and the Body buffers (copied from the block store, so that the segment mappings are not pinned). When a new block propagates many peers request the same data.
+		struct Key
+		{
+			Block::SystemState::ID m_ID;
+			uint8_t m_Code; // message type
+			uint32_t m_Count; // for HdrPack
+
+			bool operator < (const Key&) const;
+		};
+
+		struct Item
+			:public boost::intrusive::set_base_hook<>
+			,public boost::intrusive::list_base_hook<>
+		{
+			Key m_Key;
+			io::SharedBuffer m_Buf;
+			io::SharedBuffer m_Buf2; // eternal part, for Body
+
+			uint32_t get_Size() const { return static_cast<uint32_t>(m_Buf.size + m_Buf2.size); }
+
+			bool operator < (const Item& n) const { return (m_Key < n.m_Key); }
+		};
+
+		typedef boost::intrusive::list<Item> List; // least recently used first
+		typedef boost::intrusive::set<Item> Set;
+
+		List m_lst;
+		Set m_set;
+		ServeCacheStats m_Stats;
+
+		const Item* Find(const Key&);
+		void Add(const Key&, const io::SharedBuffer&, const io::SharedBuffer& buf2 = io::SharedBuffer());
+		void Delete(Item&);
+		void Clear();
+
+		~ServeCache() { Clear(); }
+
+		IMPLEMENT_GET_PARENT_OBJ(Node, m_ServeCache)
+	} m_ServeCache;
+
 	bool OnTransactionStem(Transaction::Ptr&&, const Peer*);
 	void OnTransactionAggregated(Dandelion::Element&);
 	void PerformAggregation(Dandelion::Element&);
 	void AddDummyInputs(Transaction&);
 	void AddDummyOutputs(Transaction&);
-	bool OnTransactionFluff(Transaction::Ptr&&, const Peer*, Dandelion::Element*);
+	bool OnTransactionFluff(Transaction::Ptr&&, const Peer*, Dandelion::Element*, const Transaction::Context* pCtxFree = NULL); // pCtxFree - if already passed context-free validation
+	bool OnTransactionFluffPre(const Transaction&, Transaction::KeyType&); // cheap checks before the validation. Returns false if the tx is already known
+	void DeleteStemsByKernels(const Transaction&);
 
 	bool ValidateTx(Transaction::Context&, const Transaction&); // complete validation
 	void LogTx(const Transaction&, bool bValid, const Transaction::KeyType&);
@@ -449,6 +636,8 @@ private:
 
 		Bbs::Subscription::PeerSet m_Subscriptions;
 
+		TxValidator::PerPeer m_TxPending; // guarded by TxValidator mutex
+
 		io::Timer::Ptr m_pTimer;
 		io::Timer::Ptr m_pTimerPeers;
 
@@ -607,6 +796,9 @@ private:
 		Peer* m_pFinalizer = NULL;
 		Task::Ptr m_pTaskToFinalize;
 
+		NodeProcessor::BlockTemplate m_Template;
+		bool IsCurrentTaskUpToDate(); // nothing new in the pool since the current task was generated
+
 		std::mutex m_Mutex;
 		Task::Ptr m_pTask; // currently being-mined
 
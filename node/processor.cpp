@@ -31,9 +31,9 @@ NodeProcessor::Horizon::Horizon()
 {
 }
 
-void NodeProcessor::Initialize(const char* szPath, bool bResetCursor /* = false */)
+void NodeProcessor::Initialize(const char* szPath, bool bResetCursor /* = false */, const NodeDB::Profile* pProfile /* = NULL */)
 {
-	m_DB.Open(szPath);
+	m_DB.Open(szPath, pProfile);
 	m_DbTx.Start(m_DB);
 
 	Merkle::Hash hv;
@@ -59,6 +59,7 @@ void NodeProcessor::Initialize(const char* szPath, bool bResetCursor /* = false
 	if (bResetCursor)
 		m_DB.ResetCursor();
 
+	LoadTrackedUtxos();
 	InitCursor();
 
 	InitializeFromBlocks();
@@ -75,6 +76,7 @@ NodeProcessor::~NodeProcessor()
 	if (m_DbTx.IsInProgress())
 	{
 		try {
+			SaveUtxoSnapshot(true);
 			m_DbTx.Commit();
 		} catch (std::exception& e) {
 			LOG_ERROR() << "DB Commit failed: %s" << e.what();
@@ -86,11 +88,116 @@ void NodeProcessor::CommitDB()
 {
 	if (m_DbTx.IsInProgress())
 	{
+		SaveUtxoSnapshot(false);
 		m_DbTx.Commit();
 		m_DbTx.Start(m_DB);
 	}
 }
 
+void NodeProcessor::SaveUtxoSnapshot(bool bForce)
+{
+	if (!m_UtxoSnapshotPeriod || (MaxHeight == m_hUtxoSnapshot) || (m_Cursor.m_ID.m_Height < Rules::HeightGenesis))
+		return;
+
+	if (m_Cursor.m_ID.m_Height == m_hUtxoSnapshot)
+		return;
+
+	if (!bForce && (m_hUtxoSnapshot >= Rules::HeightGenesis) && (m_Cursor.m_ID.m_Height < m_hUtxoSnapshot + m_UtxoSnapshotPeriod))
+		return;
+
+	ECC::Scalar kOffset;
+	m_Extra.m_Offset.Export(kOffset);
+
+	Serializer ser;
+	ser
+		& m_Cursor.m_ID
+		& m_Extra.m_SubsidyOpen
+		& m_Extra.m_Subsidy.Lo
+		& m_Extra.m_Subsidy.Hi
+		& kOffset;
+
+	m_Utxos.save(ser);
+
+	SerializeBuffer sb = ser.buffer();
+	Blob blob(sb.first, static_cast<uint32_t>(sb.second));
+
+	m_hUtxoSnapshot = m_Cursor.m_ID.m_Height;
+	m_DB.ParamSet(NodeDB::ParamID::UtxoSnapshot, &m_hUtxoSnapshot, &blob);
+
+	LOG_INFO() << "UTXO snapshot saved at " << m_Cursor.m_ID << ", size=" << sb.second;
+}
+
+Height NodeProcessor::LoadUtxoSnapshot()
+{
+	uint64_t h = 0;
+	ByteBuffer buf;
+	if (!m_DB.ParamGet(NodeDB::ParamID::UtxoSnapshot, &h, NULL, &buf) || buf.empty())
+		return Rules::HeightGenesis - 1;
+
+	if ((h < Rules::HeightGenesis) || (h > m_Cursor.m_ID.m_Height) || (h < get_FossilHeight()))
+		return Rules::HeightGenesis - 1; // irrelevant, or the blocks above it are already erased
+
+	try
+	{
+		NodeDB::StateID sid;
+		sid.m_Height = h;
+		sid.m_Row = FindActiveAtStrict(h);
+
+		Block::SystemState::Full s;
+		m_DB.get_State(sid.m_Row, s);
+
+		Merkle::Hash hv;
+		s.get_Hash(hv);
+
+		Block::SystemState::ID id;
+
+		Deserializer der;
+		der.reset(buf);
+		der & id;
+
+		if ((id.m_Height != h) || (id.m_Hash != hv))
+		{
+			LOG_INFO() << "UTXO snapshot " << id << " is not on the active branch";
+			return Rules::HeightGenesis - 1;
+		}
+
+		ECC::Scalar kOffset;
+		der
+			& m_Extra.m_SubsidyOpen
+			& m_Extra.m_Subsidy.Lo
+			& m_Extra.m_Subsidy.Hi
+			& kOffset;
+
+		m_Extra.m_Offset = kOffset;
+		m_Utxos.load(der);
+
+		Merkle::Hash hvHist;
+		if (m_DB.get_Prev(sid))
+			m_DB.get_PredictedStatesHash(hvHist, sid);
+		else
+			ZeroObject(hvHist);
+
+		get_Definition(hv, hvHist);
+		if (s.m_Definition == hv)
+		{
+			LOG_INFO() << "UTXO snapshot loaded at " << id;
+			return h;
+		}
+
+		LOG_WARNING() << "UTXO snapshot " << id << " definition mismatch";
+	}
+	catch (const std::exception& e)
+	{
+		LOG_WARNING() << "UTXO snapshot load failed: " << e.what();
+	}
+
+	m_Utxos.Clear();
+	ZeroObject(m_Extra);
+	m_Extra.m_SubsidyOpen = true;
+
+	return Rules::HeightGenesis - 1;
+}
+
 void NodeProcessor::InitCursor()
 {
 	if (m_DB.get_Cursor(m_Cursor.m_Sid))
@@ -270,19 +377,10 @@ void NodeProcessor::TryGoUp()
 			}
 		}
 
-		bool bPathOk = true;
-
-		for (size_t i = vPath.size(); i--; )
-		{
+		if (!vPath.empty())
 			bDirty = true;
-			if (!GoForward(vPath[i]))
-			{
-				bPathOk = false;
-				break;
-			}
-		}
 
-		if (bPathOk)
+		if (GoForward(vPath))
 			break; // at position
 	}
 
@@ -358,6 +456,7 @@ Height NodeProcessor::get_FossilHeight()
 
 void NodeProcessor::get_Definition(Merkle::Hash& hv, const Merkle::Hash& hvHist)
 {
+	PrepareUtxoHash();
 	m_Utxos.get_Hash(hv);
 	Merkle::Interpret(hv, hvHist, false);
 }
@@ -498,59 +597,72 @@ Height NodeProcessor::get_ProofKernel(Merkle::Proof& proof, TxKernel::Ptr* ppRes
 	return h;
 }
 
-bool NodeProcessor::HandleBlock(const NodeDB::StateID& sid, bool bFwd)
+struct NodeProcessor::PreparedBlock
 {
-	ByteBuffer bbP, bbE;
-	RollbackData rbData;
-	m_DB.GetStateBlock(sid.m_Row, &bbP, &bbE, &rbData.m_Buf);
+	NodeDB::StateID m_Sid;
+	Block::SystemState::Full m_State;
+	Block::SystemState::ID m_ID;
+	Block::Body m_Body;
+	RollbackData m_Rb;
+	std::vector<Merkle::Hash> m_vKrnID; // we need them for initial verification vs header, and at the end - to add to the kernel index
+	TxBase::IReader::Ptr m_pR; // for the asynchronous verification
 
-	Block::SystemState::Full s;
-	m_DB.get_State(sid.m_Row, s); // need it for logging anyway
+	bool m_bValid = false; // context-free checks performed so far
+	bool m_bFirstTime = false;
+	NodeProcessor* m_pVerifying = NULL; // asynchronous verification in progress
 
-	Block::SystemState::ID id;
-	s.get_ID(id);
+	typedef std::unique_ptr<PreparedBlock> Ptr;
+
+	void VerifyEnd()
+	{
+		if (!m_pVerifying)
+			return;
+
+		NodeProcessor& p = *m_pVerifying;
+		m_pVerifying = NULL;
+
+		if (!p.VerifyBlockEnd(m_Body, *m_pR, m_Sid.m_Height))
+		{
+			LOG_WARNING() << m_ID << " context-free verification failed";
+			m_bValid = false;
+		}
+	}
+
+	~PreparedBlock()
+	{
+		VerifyEnd(); // must not leave it running
+	}
+};
 
-	Block::Body block;
+void NodeProcessor::PrepareBlock(PreparedBlock& pb, const NodeDB::StateID& sid, bool bFwd)
+{
+	pb.m_Sid = sid;
+
+	ByteBuffer bbP, bbE;
+	m_DB.GetStateBlock(sid.m_Row, &bbP, &bbE, &pb.m_Rb.m_Buf);
+
+	m_DB.get_State(sid.m_Row, pb.m_State); // need it for logging anyway
+	pb.m_State.get_ID(pb.m_ID);
+
+	Block::Body& block = pb.m_Body;
 	try {
 		ReadBody(block, bbP, bbE);
 	}
 	catch (const std::exception&) {
-		LOG_WARNING() << id << " Block deserialization failed";
-		return false;
+		LOG_WARNING() << pb.m_ID << " Block deserialization failed";
+		return;
 	}
 
-	std::vector<Merkle::Hash> vKrnID(block.m_vKernels.size()); // allocate mem for all kernel IDs, we need them for initial verification vs header, and at the end - to add to the kernel index.
 	// better to allocate the memory, then to calculate IDs twice
-	for (size_t i = 0; i < vKrnID.size(); i++)
-		block.m_vKernels[i]->get_ID(vKrnID[i]);
-
-	bool bFirstTime = false;
+	pb.m_vKrnID.resize(block.m_vKernels.size());
+	for (size_t i = 0; i < pb.m_vKrnID.size(); i++)
+		block.m_vKernels[i]->get_ID(pb.m_vKrnID[i]);
 
 	if (bFwd)
 	{
-		if (rbData.m_Buf.empty())
+		if (pb.m_Rb.m_Buf.empty())
 		{
-			bFirstTime = true;
-
-			Difficulty::Raw wrk = m_Cursor.m_Full.m_ChainWork + s.m_PoW.m_Difficulty;
-
-			if (wrk != s.m_ChainWork)
-			{
-				LOG_WARNING() << id << " Chainwork expected=" << wrk <<", actual=" << s.m_ChainWork;
-				return false;
-			}
-
-			if (m_Cursor.m_DifficultyNext.m_Packed != s.m_PoW.m_Difficulty.m_Packed)
-			{
-				LOG_WARNING() << id << " Difficulty expected=" << m_Cursor.m_DifficultyNext << ", actual=" << s.m_PoW.m_Difficulty;
-				return false;
-			}
-
-			if (s.m_TimeStamp <= get_MovingMedian())
-			{
-				LOG_WARNING() << id << " Timestamp inconsistent wrt median";
-				return false;
-			}
+			pb.m_bFirstTime = true;
 
 			struct MyFlyMmr :public Merkle::FlyMmr {
 				const Merkle::Hash* m_pHashes;
@@ -560,29 +672,75 @@ bool NodeProcessor::HandleBlock(const NodeDB::StateID& sid, bool bFwd)
 			};
 
 			MyFlyMmr fmmr;
-			fmmr.m_Count = vKrnID.size();
-			fmmr.m_pHashes = vKrnID.empty() ? NULL : &vKrnID.front();
+			fmmr.m_Count = pb.m_vKrnID.size();
+			fmmr.m_pHashes = pb.m_vKrnID.empty() ? NULL : &pb.m_vKrnID.front();
 
 			Merkle::Hash hv;
 			fmmr.get_Hash(hv);
 
-			if (s.m_Kernels != hv)
+			if (pb.m_State.m_Kernels != hv)
 			{
-				LOG_WARNING() << id << " Kernel commitment mismatch";
-				return false;
+				LOG_WARNING() << pb.m_ID << " Kernel commitment mismatch";
+				return;
 			}
 
-			if (!VerifyBlock(block, block.get_Reader(), sid.m_Height))
-			{
-				LOG_WARNING() << id << " context-free verification failed";
-				return false;
-			}
+			block.get_Reader().Clone(pb.m_pR);
+			VerifyBlockBegin(block, *pb.m_pR, sid.m_Height);
+			pb.m_pVerifying = this;
 		}
 	}
 	else
 	{
-		assert(!rbData.m_Buf.empty());
-		rbData.Export(block);
+		assert(!pb.m_Rb.m_Buf.empty());
+		pb.m_Rb.Export(block);
+	}
+
+	pb.m_bValid = true;
+}
+
+bool NodeProcessor::HandleBlock(const NodeDB::StateID& sid, bool bFwd)
+{
+	PreparedBlock pb;
+	PrepareBlock(pb, sid, bFwd);
+	return HandleBlock(pb, bFwd);
+}
+
+bool NodeProcessor::HandleBlock(PreparedBlock& pb, bool bFwd)
+{
+	pb.VerifyEnd();
+	if (!pb.m_bValid)
+		return false;
+
+	const NodeDB::StateID& sid = pb.m_Sid;
+	const Block::SystemState::Full& s = pb.m_State;
+	const Block::SystemState::ID& id = pb.m_ID;
+	Block::Body& block = pb.m_Body;
+	RollbackData& rbData = pb.m_Rb;
+	const std::vector<Merkle::Hash>& vKrnID = pb.m_vKrnID;
+
+	bool bFirstTime = pb.m_bFirstTime;
+
+	if (bFirstTime)
+	{
+		Difficulty::Raw wrk = m_Cursor.m_Full.m_ChainWork + s.m_PoW.m_Difficulty;
+
+		if (wrk != s.m_ChainWork)
+		{
+			LOG_WARNING() << id << " Chainwork expected=" << wrk <<", actual=" << s.m_ChainWork;
+			return false;
+		}
+
+		if (m_Cursor.m_DifficultyNext.m_Packed != s.m_PoW.m_Difficulty.m_Packed)
+		{
+			LOG_WARNING() << id << " Difficulty expected=" << m_Cursor.m_DifficultyNext << ", actual=" << s.m_PoW.m_Difficulty;
+			return false;
+		}
+
+		if (s.m_TimeStamp <= get_MovingMedian())
+		{
+			LOG_WARNING() << id << " Timestamp inconsistent wrt median";
+			return false;
+		}
 	}
 
 	bool bOk = HandleValidatedBlock(block.get_Reader(), block, sid.m_Height, bFwd);
@@ -637,7 +795,7 @@ bool NodeProcessor::HandleBlock(const NodeDB::StateID& sid, bool bFwd)
 			RecognizeUtxos(std::move(r), sid.m_Height);
 		}
 		else
-			m_DB.DeleteEventsAbove(m_Cursor.m_ID.m_Height);
+			DeleteUtxoEventsAbove(m_Cursor.m_ID.m_Height);
 
 		LOG_INFO() << id << " Block interpreted. Fwd=" << bFwd;
 	}
@@ -645,74 +803,166 @@ bool NodeProcessor::HandleBlock(const NodeDB::StateID& sid, bool bFwd)
 	return bOk;
 }
 
-void NodeProcessor::RecognizeUtxos(TxBase::IReader&& r, Height hMax)
+void NodeProcessor::LoadTrackedUtxos()
 {
+	m_TrackedUtxos.clear();
+
 	NodeDB::WalkerEvent wlk(m_DB);
+	for (m_DB.EnumEvents(wlk, 0); wlk.MoveNext(); )
+	{
+		if (!wlk.m_Key.n)
+			continue; // spend event
+
+		if ((wlk.m_Key.n != sizeof(UtxoEvent::Key)) || (wlk.m_Body.n < sizeof(UtxoEvent::Value)))
+			OnCorrupted();
+
+		TrackedUtxo& tu = m_TrackedUtxos.insert(std::make_pair(*reinterpret_cast<const UtxoEvent::Key*>(wlk.m_Key.p), TrackedUtxo()))->second;
+		tu.m_Height = wlk.m_Height;
+		tu.m_Value = *reinterpret_cast<const UtxoEvent::Value*>(wlk.m_Body.p);
+	}
+}
+
+void NodeProcessor::InsertUtxoEvent(Height h, const UtxoEvent::Value& evt, const UtxoEvent::Key* pKey)
+{
+	if (pKey)
+	{
+		m_DB.InsertEvent(h, Blob(&evt, sizeof(evt)), Blob(pKey, sizeof(*pKey)));
+
+		TrackedUtxo& tu = m_TrackedUtxos.insert(std::make_pair(*pKey, TrackedUtxo()))->second;
+		tu.m_Height = h;
+		tu.m_Value = evt;
+	}
+	else
+		m_DB.InsertEvent(h, Blob(&evt, sizeof(evt)), Blob(NULL, 0));
+}
+
+void NodeProcessor::DeleteUtxoEventsAbove(Height h)
+{
+	m_DB.DeleteEventsAbove(h);
+
+	for (TrackedUtxos::iterator it = m_TrackedUtxos.begin(); m_TrackedUtxos.end() != it; )
+	{
+		if (it->second.m_Height > h)
+			it = m_TrackedUtxos.erase(it);
+		else
+			++it;
+	}
+}
 
-	for ( ; r.m_pUtxoIn; r.NextUtxoIn())
+void NodeProcessor::RecognizeUtxos(TxBase::IReader&& r, Height hMax)
+{
+	for ( ; r.m_pUtxoIn && !m_TrackedUtxos.empty(); r.NextUtxoIn())
 	{
 		const Input& x = *r.m_pUtxoIn;
 		assert(x.m_Maturity); // must've already been validated
 
 		const UtxoEvent::Key& key = x.m_Commitment;
 
-		m_DB.FindEvents(wlk, Blob(&key, sizeof(key))); // raw find (each time from scratch) is suboptimal, because inputs are sorted, should be a way to utilize this
-		if (wlk.MoveNext())
-		{
-			if (wlk.m_Body.n < sizeof(UtxoEvent::Value))
-				OnCorrupted();
+		TrackedUtxos::const_iterator it = m_TrackedUtxos.find(key);
+		if (m_TrackedUtxos.end() == it)
+			continue;
 
-			UtxoEvent::Value evt = *reinterpret_cast<const UtxoEvent::Value*>(wlk.m_Body.p); // copy
-			evt.m_Maturity = x.m_Maturity;
+		UtxoEvent::Value evt = it->second.m_Value; // copy
+		evt.m_Maturity = x.m_Maturity;
 
-			// In case of macroblock we can't recover the original input height. But in our current implementation macroblocks always go from the beginning, hence they don't contain input.
-			m_DB.InsertEvent(hMax, Blob(&evt, sizeof(evt)), Blob(NULL, 0));
-		}
+		// In case of macroblock we can't recover the original input height. But in our current implementation macroblocks always go from the beginning, hence they don't contain input.
+		InsertUtxoEvent(hMax, evt, NULL);
 	}
 
-	for (; r.m_pUtxoOut; r.NextUtxoOut())
+	struct KeyCounter :public IKeyWalker
 	{
-		const Output& x = *r.m_pUtxoOut;
+		uint32_t m_Count = 0;
 
-		struct Walker :public IKeyWalker
+		virtual bool OnKey(Key::IPKdf&, Key::Index) override
 		{
-			const Output& m_Output;
-			UtxoEvent::Value m_Value;
+			m_Count++;
+			return true;
+		}
+	} kc;
 
-			Walker(const Output& x) :m_Output(x) {}
+	EnumViewerKeys(kc);
+	if (!kc.m_Count)
+		return;
 
-			virtual bool OnKey(Key::IPKdf& kdf, Key::Index iKdf) override
-			{
-				Key::IDV kidv;
-				if (!m_Output.Recover(kdf, kidv))
-					return true; // continue enumeration
+	// Outputs are recovered in batches (the reader may reuse the output objects, hence they're copied).
+	// The events are inserted in the original order.
+	const uint32_t nBatch = 1024;
+	std::vector<Output::Ptr> vOuts;
+	std::vector<const Output*> vPtrs;
+	std::vector<RecoveredOutput> vRes;
 
-				m_Value.m_iKdf = iKdf;
-				m_Value.m_Kidv = kidv;
-				return false; // stop
+	while (r.m_pUtxoOut)
+	{
+		uint32_t n = 0;
+		for (; r.m_pUtxoOut && (n < nBatch); r.NextUtxoOut(), n++)
+		{
+			if (vOuts.size() == n)
+			{
+				vOuts.emplace_back(new Output);
+				vPtrs.push_back(vOuts.back().get());
 			}
-		};
 
-		Walker w(x);
-		if (!EnumViewerKeys(w))
+			*vOuts[n] = *r.m_pUtxoOut;
+		}
+
+		vRes.resize(n);
+		RecoverOutputs(&vRes.front(), &vPtrs.front(), n);
+
+		for (uint32_t i = 0; i < n; i++)
 		{
+			const RecoveredOutput& ro = vRes[i];
+			if (!ro.m_Recovered)
+				continue;
+
 			// bingo!
+			const Output& x = *vOuts[i];
+
+			UtxoEvent::Value evt;
+			evt.m_iKdf = ro.m_iKdf;
+			evt.m_Kidv = ro.m_Kidv;
+
 			Height h;
 			if (x.m_Maturity)
 			{
-				w.m_Value.m_Maturity = x.m_Maturity;
+				evt.m_Maturity = x.m_Maturity;
 				// try to reverse-engineer the original block from the maturity
 				h = x.m_Maturity - x.get_MinMaturity(0);
 			}
 			else
 			{
 				h = hMax;
-				w.m_Value.m_Maturity = x.get_MinMaturity(h);
+				evt.m_Maturity = x.get_MinMaturity(h);
 			}
 
 			const UtxoEvent::Key& key = x.m_Commitment;
-			m_DB.InsertEvent(h, Blob(&w.m_Value, sizeof(w.m_Value)), Blob(&key, sizeof(key)));
+			InsertUtxoEvent(h, evt, &key);
+		}
+	}
+}
+
+void NodeProcessor::RecoverOutputs(RecoveredOutput* pRes, const Output* const* ppOuts, uint32_t nCount)
+{
+	struct Walker :public IKeyWalker
+	{
+		const Output* m_pOutput;
+		RecoveredOutput* m_pRes;
+
+		virtual bool OnKey(Key::IPKdf& kdf, Key::Index iKdf) override
+		{
+			if (!m_pOutput->Recover(kdf, m_pRes->m_Kidv))
+				return true; // continue enumeration
+
+			m_pRes->m_iKdf = iKdf;
+			return false; // stop
 		}
+	};
+
+	for (uint32_t i = 0; i < nCount; i++)
+	{
+		Walker w;
+		w.m_pOutput = ppOuts[i];
+		w.m_pRes = pRes + i;
+		pRes[i].m_Recovered = !EnumViewerKeys(w);
 	}
 }
 
@@ -932,13 +1182,13 @@ void NodeProcessor::ToggleSubsidyOpened()
 	}
 }
 
-bool NodeProcessor::GoForward(uint64_t row)
+bool NodeProcessor::GoForward(PreparedBlock& pb)
 {
-	NodeDB::StateID sid;
-	sid.m_Height = m_Cursor.m_Sid.m_Height + 1;
-	sid.m_Row = row;
+	const NodeDB::StateID& sid = pb.m_Sid;
+	uint64_t row = sid.m_Row;
+	assert(sid.m_Height == m_Cursor.m_Sid.m_Height + 1);
 
-	if (HandleBlock(sid, true))
+	if (HandleBlock(pb, true))
 	{
 		m_DB.MoveFwd(sid);
 		InitCursor();
@@ -958,6 +1208,42 @@ bool NodeProcessor::GoForward(uint64_t row)
 	return false;
 }
 
+bool NodeProcessor::GoForward(const std::vector<uint64_t>& vPath)
+{
+	PreparedBlock::Ptr pNext;
+
+	for (size_t i = vPath.size(); i--; )
+	{
+		NodeDB::StateID sid;
+		sid.m_Height = m_Cursor.m_Sid.m_Height + 1;
+		sid.m_Row = vPath[i];
+
+		PreparedBlock::Ptr pb(std::move(pNext));
+		if (!pb)
+		{
+			pb.reset(new PreparedBlock);
+			PrepareBlock(*pb, sid, true);
+		}
+
+		pb->VerifyEnd();
+
+		if (i)
+		{
+			// verify the next block while this one is being interpreted
+			sid.m_Height++;
+			sid.m_Row = vPath[i - 1];
+
+			pNext.reset(new PreparedBlock);
+			PrepareBlock(*pNext, sid, true);
+		}
+
+		if (!GoForward(*pb))
+			return false;
+	}
+
+	return true;
+}
+
 void NodeProcessor::Rollback()
 {
 	NodeDB::StateID sid = m_Cursor.m_Sid;
@@ -969,14 +1255,17 @@ void NodeProcessor::Rollback()
 
 	InitCursor(); // needed to refresh subsidy-open flag. Otherwise isn't necessary
 
+	if ((m_hUtxoSnapshot != MaxHeight) && (m_Cursor.m_ID.m_Height < m_hUtxoSnapshot))
+		m_hUtxoSnapshot = Rules::HeightGenesis - 1; // the saved snapshot is no longer on the active branch
+
 	OnRolledBack();
 }
 
-NodeProcessor::DataStatus::Enum NodeProcessor::OnStateInternal(const Block::SystemState::Full& s, Block::SystemState::ID& id)
+NodeProcessor::DataStatus::Enum NodeProcessor::OnStateInternal(const Block::SystemState::Full& s, Block::SystemState::ID& id, bool bPoWChecked /* = false */)
 {
 	s.get_ID(id);
 
-	if (!s.IsValid())
+	if (!(bPoWChecked ? s.IsSane() : s.IsValid()))
 	{
 		LOG_WARNING() << id << " header invalid!";
 		return DataStatus::Invalid;
@@ -1009,10 +1298,15 @@ NodeProcessor::DataStatus::Enum NodeProcessor::OnStateInternal(const Block::Syst
 }
 
 NodeProcessor::DataStatus::Enum NodeProcessor::OnState(const Block::SystemState::Full& s, const PeerID& peer)
+{
+	return OnStateChecked(s, peer, false);
+}
+
+NodeProcessor::DataStatus::Enum NodeProcessor::OnStateChecked(const Block::SystemState::Full& s, const PeerID& peer, bool bPoWChecked)
 {
 	Block::SystemState::ID id;
 
-	DataStatus::Enum ret = OnStateInternal(s, id);
+	DataStatus::Enum ret = OnStateInternal(s, id, bPoWChecked);
 	if (DataStatus::Accepted == ret)
 	{
 		uint64_t rowid = m_DB.InsertState(s);
@@ -1025,6 +1319,45 @@ NodeProcessor::DataStatus::Enum NodeProcessor::OnState(const Block::SystemState:
 	return ret;
 }
 
+uint32_t NodeProcessor::OnStates(const Block::SystemState::Full* pS, uint32_t n, const PeerID& peer, uint32_t& nAccepted)
+{
+	nAccepted = 0;
+
+	uint32_t nValidPoW = VerifyPoW(pS, n);
+	if (nValidPoW < n)
+	{
+		Block::SystemState::ID id;
+		pS[nValidPoW].get_ID(id);
+		LOG_WARNING() << id << " PoW invalid";
+	}
+
+	for (uint32_t i = 0; i < nValidPoW; i++)
+	{
+		switch (OnStateChecked(pS[i], peer, true))
+		{
+		case DataStatus::Invalid:
+			return i;
+
+		case DataStatus::Accepted:
+			nAccepted++;
+
+		default:
+			break; // suppress warning
+		}
+	}
+
+	return nValidPoW;
+}
+
+uint32_t NodeProcessor::VerifyPoW(const Block::SystemState::Full* pS, uint32_t n)
+{
+	for (uint32_t i = 0; i < n; i++)
+		if (!IsValidPoW(pS[i]))
+			return i;
+
+	return n;
+}
+
 NodeProcessor::DataStatus::Enum NodeProcessor::OnBlock(const Block::SystemState::ID& id, const Blob& bbP, const Blob& bbE, const PeerID& peer)
 {
 	size_t nSize = size_t(bbP.n) + size_t(bbE.n);
@@ -1299,10 +1632,50 @@ size_t NodeProcessor::GenerateNewBlockInternal(BlockContext& bc)
 
 	size_t nTxNum = 0;
 
+	BlockTemplate* pT = bc.m_pTemplate;
+	if (pT)
+	{
+		if (pT->m_Tip == m_Cursor.m_ID)
+		{
+			// re-apply the txs selected previously, they're already validated in this context
+			for (size_t i = 0; i < pT->m_vTxs.size(); i++)
+			{
+				const BlockTemplate::Entry& e = pT->m_vTxs[i];
+				const Transaction& tx = *e.m_pTx;
+
+				size_t nSizeNext = ssc.m_Counter.m_Value + e.m_nSize;
+				if (!bc.m_Fees && e.m_Fee)
+					nSizeNext += m_nSizeUtxoComission;
+
+				if ((nSizeNext > nSizeMax) || !HandleValidatedTx(tx.get_Reader(), h, true))
+				{
+					// shouldn't happen. Drop the rest, they remain marked as tried until the tip changes
+					pT->m_vTxs.resize(i);
+					break;
+				}
+
+				TxVectors::Writer(bc.m_Block, bc.m_Block).Dump(tx.get_Reader());
+
+				bc.m_Fees += e.m_Fee;
+				ssc.m_Counter.m_Value = nSizeNext;
+				offset += ECC::Scalar::Native(tx.m_Offset);
+				++nTxNum;
+			}
+		}
+		else
+		{
+			pT->Reset();
+			pT->m_Tip = m_Cursor.m_ID;
+		}
+	}
+
 	for (TxPool::Fluff::ProfitSet::iterator it = bc.m_TxPool.m_setProfit.begin(); bc.m_TxPool.m_setProfit.end() != it; )
 	{
 		TxPool::Fluff::Element& x = (it++)->get_ParentObj();
 
+		if (pT && !pT->m_setTried.insert(x.m_Tx.m_Key).second)
+			continue; // already considered for this tip
+
 		if (x.m_Profit.m_Fee.Hi)
 		{
 			// huge fees are unsupported
@@ -1337,6 +1710,15 @@ size_t NodeProcessor::GenerateNewBlockInternal(BlockContext& bc)
 		{
 			TxVectors::Writer(bc.m_Block, bc.m_Block).Dump(tx.get_Reader());
 
+			if (pT)
+			{
+				pT->m_vTxs.emplace_back();
+				BlockTemplate::Entry& e = pT->m_vTxs.back();
+				e.m_pTx = x.m_pValue;
+				e.m_Fee = feesNext - bc.m_Fees;
+				e.m_nSize = x.m_Profit.m_nSize;
+			}
+
 			bc.m_Fees = feesNext;
 			ssc.m_Counter.m_Value = nSizeNext;
 			offset += ECC::Scalar::Native(tx.m_Offset);
@@ -1407,6 +1789,22 @@ void NodeProcessor::GenerateNewHdr(BlockContext& bc)
 	bc.m_Hdr.m_TimeStamp = std::max(bc.m_Hdr.m_TimeStamp, tm);
 }
 
+void NodeProcessor::BlockTemplate::Reset()
+{
+	m_Tip.m_Height = MaxHeight; // matches no tip
+	m_vTxs.clear();
+	m_setTried.clear();
+}
+
+bool NodeProcessor::BlockTemplate::HasUntried(const TxPool::Fluff& txp) const
+{
+	for (TxPool::Fluff::ProfitSet::const_iterator it = txp.m_setProfit.begin(); txp.m_setProfit.end() != it; it++)
+		if (m_setTried.end() == m_setTried.find(it->get_ParentObj().m_Tx.m_Key))
+			return true;
+
+	return false;
+}
+
 NodeProcessor::BlockContext::BlockContext(TxPool::Fluff& txp, Key::IKdf& kdf)
 	:m_TxPool(txp)
 	,m_Kdf(kdf)
@@ -1489,7 +1887,12 @@ bool NodeProcessor::GenerateNewBlock(BlockContext& bc)
 
 bool NodeProcessor::VerifyBlock(const Block::BodyBase& block, TxBase::IReader&& r, const HeightRange& hr)
 {
-	return block.IsValid(hr, m_Extra.m_SubsidyOpen, std::move(r));
+	return block.IsValid(hr, m_Extra.m_SubsidyOpen, std::move(r), &m_PointCache);
+}
+
+bool NodeProcessor::VerifyBlockEnd(const Block::BodyBase& block, TxBase::IReader& r, const HeightRange& hr)
+{
+	return VerifyBlock(block, std::move(r), hr);
 }
 
 void NodeProcessor::ExtractBlockWithExtra(Block::Body& block, const NodeDB::StateID& sid)
@@ -1614,6 +2017,14 @@ bool NodeProcessor::ImportMacroBlockInternal(Block::BodyBase::IMacroReader& r)
 	Block::SystemState::Full s;
 	Block::SystemState::ID id;
 
+	// count the headers first, the height range is needed for the body verification
+	uint32_t nHdrs = 0;
+	r.Reset();
+	r.get_Start(body, s);
+
+	for (Block::SystemState::Sequence::Element e; r.get_NextHdr(e); )
+		nHdrs++;
+
 	r.Reset();
 	r.get_Start(body, s);
 
@@ -1632,7 +2043,13 @@ bool NodeProcessor::ImportMacroBlockInternal(Block::BodyBase::IMacroReader& r)
 		return false; // incompatible beginning state
 	}
 
-	Merkle::CompactMmr cmmr, cmmrKrn;
+	if (!nHdrs)
+	{
+		LOG_WARNING() << "No headers";
+		return false;
+	}
+
+	Merkle::CompactMmr cmmr;
 	if (m_Cursor.m_ID.m_Height > Rules::HeightGenesis)
 	{
 		Merkle::ProofBuilderHard bld;
@@ -1645,80 +2062,32 @@ bool NodeProcessor::ImportMacroBlockInternal(Block::BodyBase::IMacroReader& r)
 		cmmr.Append(m_Cursor.m_Full.m_Prev);
 	}
 
-	LOG_INFO() << "Verifying headers...";
-
-	for (bool bFirstTime = true ; r.get_NextHdr(s); s.NextPrefix())
-	{
-		// Difficulty check?!
-
-		if (bFirstTime)
-		{
-			bFirstTime = false;
-
-			Difficulty::Raw wrk = m_Cursor.m_Full.m_ChainWork + s.m_PoW.m_Difficulty;
-
-			if (wrk != s.m_ChainWork)
-			{
-				LOG_WARNING() << id << " Chainwork expected=" << wrk << ", actual=" << s.m_ChainWork;
-				return false;
-			}
-		}
-		else
-			s.m_ChainWork += s.m_PoW.m_Difficulty;
-
-		if (id.m_Height >= Rules::HeightGenesis)
-			cmmr.Append(id.m_Hash);
-
-		switch (OnStateInternal(s, id))
-		{
-		case DataStatus::Invalid:
-		{
-			LOG_WARNING() << "Invald header encountered: " << id;
-			return false;
-		}
-
-		case DataStatus::Accepted:
-			m_DB.InsertState(s);
-
-		default: // suppress the warning of not handling all the enum values
-			break;
-		}
+	// The context-free body validation (ui, uo, ko, kx) runs on the verification threads (if any) on its own reader,
+	// while the headers, their PoW and the kernel commitments (hd, ko) are verified here.
+	HeightRange hr(m_Cursor.m_ID.m_Height + 1, m_Cursor.m_ID.m_Height + nHdrs);
 
-		// verify kernel commitment
-		cmmrKrn.m_Count = 0;
-		cmmrKrn.m_vNodes.clear();
+	TxBase::IReader::Ptr pR;
+	r.Clone(pR);
 
-		// don't care if kernels are out-of-order, this will be handled during the context-free validation.
-		for (; r.m_pKernel && (r.m_pKernel->m_Maturity == s.m_Height); r.NextKernel())
-		{
-			Merkle::Hash hv;
-			r.m_pKernel->get_ID(hv);
-			cmmrKrn.Append(hv);
-		}
+	LOG_INFO() << "Context-free validation...";
+	VerifyBlockBegin(body, *pR, hr);
 
-		Merkle::Hash hv;
-		cmmrKrn.get_Hash(hv);
+	LOG_INFO() << "Verifying headers...";
 
-		if (s.m_Kernels != hv)
-		{
-			LOG_WARNING() << id << " Kernel commitment mismatch";
-			return false;
-		}
-	}
+	KrnIDs vKrnIDs;
+	bool bHdrsValid = ImportMacroBlockHdrs(r, s, id, cmmr, vKrnIDs, nHdrs);
 
-	if (r.m_pKernel)
+	// must wait for the body verification anyway
+	if (!VerifyBlockEnd(body, *pR, hr))
 	{
-		LOG_WARNING() << "Kernel maturity OOB";
+		LOG_WARNING() << "Context-free verification failed";
 		return false;
 	}
 
-	LOG_INFO() << "Context-free validation...";
-
-	if (!VerifyBlock(body, std::move(r), HeightRange(m_Cursor.m_ID.m_Height + 1, id.m_Height)))
-	{
-		LOG_WARNING() << "Context-free verification failed";
+	if (!bHdrsValid)
 		return false;
-	}
+
+	assert(id.m_Height == hr.m_Max);
 
 	LOG_INFO() << "Applying macroblock...";
 
@@ -1745,6 +2114,7 @@ bool NodeProcessor::ImportMacroBlockInternal(Block::BodyBase::IMacroReader& r)
 	// Update DB state flags and cursor. This will also buils the MMR for prev states
 	LOG_INFO() << "Building auxilliary datas...";
 
+	uint32_t iHdr = 0;
 	r.Reset();
 	r.get_Start(body, s);
 	for (bool bFirstTime = true; r.get_NextHdr(s); s.NextPrefix())
@@ -1768,15 +2138,14 @@ bool NodeProcessor::ImportMacroBlockInternal(Block::BodyBase::IMacroReader& r)
 
 		sid.m_Height = id.m_Height;
 		m_DB.MoveFwd(sid);
-	}
 
-	// kernels
-	for (; r.m_pKernel; r.NextKernel())
-	{
-		r.m_pKernel->get_ID(hv);
-		m_DB.InsertKernel(hv, r.m_pKernel->m_Maturity);
+		OnMacroblockProgress(nHdrs + ++iHdr, nHdrs * 2);
 	}
 
+	// kernels, their IDs were already evaluated during the verification
+	for (size_t i = 0; i < vKrnIDs.size(); i++)
+		m_DB.InsertKernel(vKrnIDs[i].second, vKrnIDs[i].first);
+
 	LOG_INFO() << "Recovering owner UTXOs...";
 	RecognizeUtxos(std::move(r), id.m_Height);
 
@@ -1790,6 +2159,84 @@ bool NodeProcessor::ImportMacroBlockInternal(Block::BodyBase::IMacroReader& r)
 	return true;
 }
 
+bool NodeProcessor::ImportMacroBlockHdrs(Block::BodyBase::IMacroReader& r, Block::SystemState::Full& s, Block::SystemState::ID& id, Merkle::CompactMmr& cmmr, KrnIDs& vKrnIDs, uint32_t nHdrs)
+{
+	Merkle::CompactMmr cmmrKrn;
+	uint32_t iHdr = 0;
+
+	for (bool bFirstTime = true ; r.get_NextHdr(s); s.NextPrefix())
+	{
+		// Difficulty check?!
+
+		if (bFirstTime)
+		{
+			bFirstTime = false;
+
+			Difficulty::Raw wrk = m_Cursor.m_Full.m_ChainWork + s.m_PoW.m_Difficulty;
+
+			if (wrk != s.m_ChainWork)
+			{
+				LOG_WARNING() << id << " Chainwork expected=" << wrk << ", actual=" << s.m_ChainWork;
+				return false;
+			}
+		}
+		else
+			s.m_ChainWork += s.m_PoW.m_Difficulty;
+
+		if (id.m_Height >= Rules::HeightGenesis)
+			cmmr.Append(id.m_Hash);
+
+		switch (OnStateInternal(s, id))
+		{
+		case DataStatus::Invalid:
+		{
+			LOG_WARNING() << "Invald header encountered: " << id;
+			return false;
+		}
+
+		case DataStatus::Accepted:
+			m_DB.InsertState(s);
+
+		default: // suppress the warning of not handling all the enum values
+			break;
+		}
+
+		// verify kernel commitment
+		cmmrKrn.m_Count = 0;
+		cmmrKrn.m_vNodes.clear();
+
+		// don't care if kernels are out-of-order, this will be handled during the context-free validation.
+		for (; r.m_pKernel && (r.m_pKernel->m_Maturity == s.m_Height); r.NextKernel())
+		{
+			vKrnIDs.emplace_back();
+			vKrnIDs.back().first = s.m_Height;
+
+			Merkle::Hash& hv = vKrnIDs.back().second;
+			r.m_pKernel->get_ID(hv);
+			cmmrKrn.Append(hv);
+		}
+
+		Merkle::Hash hv;
+		cmmrKrn.get_Hash(hv);
+
+		if (s.m_Kernels != hv)
+		{
+			LOG_WARNING() << id << " Kernel commitment mismatch";
+			return false;
+		}
+
+		OnMacroblockProgress(++iHdr, nHdrs * 2);
+	}
+
+	if (r.m_pKernel)
+	{
+		LOG_WARNING() << "Kernel maturity OOB";
+		return false;
+	}
+
+	return true;
+}
+
 Height NodeProcessor::OpenLatestMacroblock(Block::Body::RW& rw)
 {
 	NodeDB::WalkerState ws(m_DB);
@@ -1805,24 +2252,27 @@ Height NodeProcessor::OpenLatestMacroblock(Block::Body::RW& rw)
 	return Rules::HeightGenesis - 1;
 }
 
-bool NodeProcessor::EnumBlocks(IBlockWalker& wlk)
+bool NodeProcessor::EnumBlocks(IBlockWalker& wlk, Height h /* = Rules::HeightGenesis - 1 */)
 {
 	if (m_Cursor.m_ID.m_Height < Rules::HeightGenesis)
 		return true;
 
-	Block::Body::RW rw;
-
-	Height h = OpenLatestMacroblock(rw);
-	if (h >= Rules::HeightGenesis)
+	if (h < Rules::HeightGenesis)
 	{
-		Block::BodyBase body;
-		Block::SystemState::Sequence::Prefix prefix;
+		Block::Body::RW rw;
 
-		rw.Reset();
-		rw.get_Start(body, prefix);
+		h = OpenLatestMacroblock(rw);
+		if (h >= Rules::HeightGenesis)
+		{
+			Block::BodyBase body;
+			Block::SystemState::Sequence::Prefix prefix;
 
-		if (!wlk.OnBlock(body, std::move(rw), 0, Rules::HeightGenesis, &h))
-			return false;
+			rw.Reset();
+			rw.get_Start(body, prefix);
+
+			if (!wlk.OnBlock(body, std::move(rw), 0, Rules::HeightGenesis, &h))
+				return false;
+		}
 	}
 
 	std::vector<uint64_t> vPath;
@@ -1889,9 +2339,15 @@ void NodeProcessor::InitializeFromBlocks()
 		}
 	};
 
+	Height hSnapshot = Rules::HeightGenesis - 1;
+	if (m_UtxoSnapshotPeriod && (m_Cursor.m_ID.m_Height >= Rules::HeightGenesis))
+		hSnapshot = LoadUtxoSnapshot();
+
 	MyWalker wlk;
 	wlk.m_pThis = this;
-	EnumBlocks(wlk);
+	EnumBlocks(wlk, hSnapshot);
+
+	m_hUtxoSnapshot = hSnapshot;
 
 	if (m_Cursor.m_ID.m_Height >= Rules::HeightGenesis)
 	{
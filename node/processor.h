@@ -17,6 +17,7 @@
 #include "../core/radixtree.h"
 #include "db.h"
 #include "txpool.h"
+#include <set>
 
 namespace beam {
 
@@ -33,27 +34,38 @@ class NodeProcessor
 	NodeDB::Transaction m_DbTx;
 
 	UtxoTree m_Utxos;
+	Height m_hUtxoSnapshot = MaxHeight; // height of the last saved snapshot. MaxHeight - not initialized yet
 
 	size_t m_nSizeUtxoComission;
 
 	void TryGoUp();
 
-	bool GoForward(uint64_t);
+	struct PreparedBlock;
+	void PrepareBlock(PreparedBlock&, const NodeDB::StateID&, bool bFwd); // loads, and for the new blocks starts the context-free verification
+
+	bool GoForward(PreparedBlock&);
+	bool GoForward(const std::vector<uint64_t>& vPath); // pipelined: the verification of each block overlaps the interpretation of the previous one
 	void Rollback();
 	void PruneOld();
 	void InitializeFromBlocks();
+	Height LoadUtxoSnapshot();
+	void SaveUtxoSnapshot(bool bForce);
 	void RequestDataInternal(const Block::SystemState::ID&, uint64_t row, bool bBlock);
 
 	struct RollbackData;
 
 	bool HandleBlock(const NodeDB::StateID&, bool bFwd);
+	bool HandleBlock(PreparedBlock&, bool bFwd);
 	bool HandleValidatedTx(TxBase::IReader&&, Height, bool bFwd, const Height* = NULL);
 	bool HandleValidatedBlock(TxBase::IReader&&, const Block::BodyBase&, Height, bool bFwd, const Height* = NULL);
 	bool HandleBlockElement(const Input&, Height, const Height*, bool bFwd);
 	bool HandleBlockElement(const Output&, Height, const Height*, bool bFwd);
 	void ToggleSubsidyOpened();
 
+	typedef std::vector<std::pair<Height, Merkle::Hash> > KrnIDs;
+
 	bool ImportMacroBlockInternal(Block::BodyBase::IMacroReader&);
+	bool ImportMacroBlockHdrs(Block::BodyBase::IMacroReader&, Block::SystemState::Full&, Block::SystemState::ID&, Merkle::CompactMmr&, KrnIDs&, uint32_t nHdrs);
 	void RecognizeUtxos(TxBase::IReader&&, Height hMax);
 
 	static void SquashOnce(std::vector<Block::Body>&);
@@ -90,12 +102,12 @@ class NodeProcessor
 		virtual bool OnOutput(const Output&) = 0;
 	};
 
-	bool EnumBlocks(IBlockWalker&);
+	bool EnumBlocks(IBlockWalker&, Height hFrom = Rules::HeightGenesis - 1); // blocks up to hFrom (incl. macroblock) are assumed already interpreted
 	Height OpenLatestMacroblock(Block::Body::RW&);
 
 public:
 
-	void Initialize(const char* szPath, bool bResetCursor = false);
+	void Initialize(const char* szPath, bool bResetCursor = false, const NodeDB::Profile* = NULL);
 	virtual ~NodeProcessor();
 
 	struct Horizon {
@@ -107,6 +119,10 @@ public:
 
 	} m_Horizon;
 
+	Height m_UtxoSnapshotPeriod = 1440; // save the UTXO set each N blocks, so that on startup only the blocks above it are interpreted. 0 - disabled
+
+	ECC::PointCache m_PointCache; // decompressed commitments of the validated outputs, for their inputs. Disabled by default
+
 	struct Cursor
 	{
 		// frequently used data
@@ -144,11 +160,15 @@ public:
 	};
 
 	DataStatus::Enum OnState(const Block::SystemState::Full&, const PeerID&);
+	// Batch acceptance of headers. The PoW of all of them is verified first (possibly in parallel), then they're processed sequentially.
+	// Stops at the 1st invalid header and returns its index, or n if all are valid.
+	uint32_t OnStates(const Block::SystemState::Full*, uint32_t n, const PeerID&, uint32_t& nAccepted);
 	DataStatus::Enum OnBlock(const Block::SystemState::ID&, const Blob& bbP, const Blob& bbE, const PeerID&);
 
 	// use only for data retrieval for peers
 	NodeDB& get_DB() { return m_DB; }
 	UtxoTree& get_Utxos() { return m_Utxos; }
+	Height get_UtxoSnapshot() const { return m_hUtxoSnapshot; } // the startup interpretation resumed above it
 	static void ReadBody(Block::Body&, const ByteBuffer& bbP, const ByteBuffer& bbE);
 
 	Height get_ProofKernel(Merkle::Proof&, TxKernel::Ptr*, const Merkle::Hash& idKrn);
@@ -162,19 +182,37 @@ public:
 	virtual void OnNewState() {}
 	virtual void OnRolledBack() {}
 	virtual bool VerifyBlock(const Block::BodyBase&, TxBase::IReader&&, const HeightRange&);
+	// Asynchronous context-free verification, used to verify the next block while the current one is being interpreted.
+	// The block and the reader must be kept alive until VerifyBlockEnd(). By default the verification is performed in VerifyBlockEnd().
+	virtual void VerifyBlockBegin(const Block::BodyBase&, TxBase::IReader&, const HeightRange&) {}
+	virtual bool VerifyBlockEnd(const Block::BodyBase&, TxBase::IReader&, const HeightRange&);
 	virtual bool ApproveState(const Block::SystemState::ID&) { return true; }
 	virtual void AdjustFossilEnd(Height&) {}
 	virtual void OnStateData() {}
 	virtual void OnBlockData() {}
 	virtual void OnUpToDate() {}
+	virtual void OnMacroblockProgress(uint32_t nDone, uint32_t nTotal) {}
 	virtual bool OpenMacroblock(Block::BodyBase::RW&, const NodeDB::StateID&) { return false; }
 	virtual void OnModified() {}
+	virtual void PrepareUtxoHash() {} // may evaluate the dirty UTXO subtrees in parallel, before the final get_Hash()
+	virtual uint32_t VerifyPoW(const Block::SystemState::Full*, uint32_t n); // returns the index of the 1st invalid, or n if all are valid
+	virtual bool IsValidPoW(const Block::SystemState::Full& s) { return s.IsValidPoW(); } // may be called from arbitrary threads
 
 	struct IKeyWalker {
 		virtual bool OnKey(Key::IPKdf&, Key::Index) = 0;
 	};
 	virtual bool EnumViewerKeys(IKeyWalker&) { return true; }
 
+	struct RecoveredOutput
+	{
+		bool m_Recovered;
+		Key::Index m_iKdf;
+		Key::IDV m_Kidv;
+	};
+
+	// tries the viewer keys for each output. If several keys fit - the 1st one (in EnumViewerKeys order) is taken. May run in parallel.
+	virtual void RecoverOutputs(RecoveredOutput*, const Output* const*, uint32_t nCount);
+
 	uint64_t FindActiveAtStrict(Height);
 
 	bool ValidateTxContext(const Transaction&); // assuming context-free validation is already performed, but 
@@ -190,11 +228,33 @@ public:
 	};
 
 
+	// Txs selected for the block on top of the specific tip. Subsequent generations re-apply them w/o selection,
+	// and only try the pool txs that weren't considered yet. Starts anew once the tip changes.
+	struct BlockTemplate
+	{
+		Block::SystemState::ID m_Tip;
+
+		struct Entry
+		{
+			Transaction::Ptr m_pTx;
+			Amount m_Fee;
+			uint32_t m_nSize;
+		};
+
+		std::vector<Entry> m_vTxs; // in order of selection
+		std::set<Transaction::KeyType> m_setTried; // selected or rejected
+
+		BlockTemplate() { Reset(); }
+		void Reset();
+		bool HasUntried(const TxPool::Fluff&) const;
+	};
+
 	struct BlockContext
 		:public GeneratedBlock
 	{
 		TxPool::Fluff& m_TxPool;
-		Key::IKdf& m_Kdf;
+		Key::IKdf& m_Kdf;
+		BlockTemplate* m_pTemplate = NULL; // optional
 
 		enum Mode {
 			Assemble,
@@ -260,9 +320,24 @@ public:
 #pragma pack (pop)
 
 private:
+	// In-memory copy of the keyed (recognized output) events, to match the block inputs w/o DB access.
+	struct TrackedUtxo
+	{
+		Height m_Height;
+		UtxoEvent::Value m_Value;
+	};
+
+	typedef std::multimap<UtxoEvent::Key, TrackedUtxo> TrackedUtxos;
+	TrackedUtxos m_TrackedUtxos;
+
+	void LoadTrackedUtxos();
+	void InsertUtxoEvent(Height, const UtxoEvent::Value&, const UtxoEvent::Key*);
+	void DeleteUtxoEventsAbove(Height);
+
 	size_t GenerateNewBlockInternal(BlockContext&);
 	void GenerateNewHdr(BlockContext&);
-	DataStatus::Enum OnStateInternal(const Block::SystemState::Full&, Block::SystemState::ID&);
+	DataStatus::Enum OnStateInternal(const Block::SystemState::Full&, Block::SystemState::ID&, bool bPoWChecked = false);
+	DataStatus::Enum OnStateChecked(const Block::SystemState::Full&, const PeerID&, bool bPoWChecked);
 };
 
 
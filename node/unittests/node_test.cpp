@@ -438,8 +438,45 @@ namespace beam
 		db.DeleteKernel(bBodyP, 5);
 		verify_test(db.FindKernel(bBodyP) == 0);
 
+		// Kernel filter: no false negatives, most misses don't reach the DB. Exceeds the initial filter capacity.
+		const uint32_t nKrns = 2000;
+		for (uint32_t i = 0; i < nKrns; i++)
+		{
+			ECC::Hash::Value hv;
+			ECC::Hash::Processor() << i >> hv;
+			db.InsertKernel(hv, 10);
+		}
+
+		NodeDB::KernelFilterStats kfs = db.get_KernelFilterStats();
+
+		for (uint32_t i = 0; i < nKrns * 2; i++)
+		{
+			ECC::Hash::Value hv;
+			ECC::Hash::Processor() << i >> hv;
+			verify_test(db.FindKernel(hv) == ((i < nKrns) ? 10 : 0));
+		}
+
+		const NodeDB::KernelFilterStats& kfs2 = db.get_KernelFilterStats();
+		verify_test(kfs2.m_Lookups - kfs.m_Lookups == nKrns * 2);
+		verify_test((kfs2.m_Negatives - kfs.m_Negatives) + (kfs2.m_FalsePositives - kfs.m_FalsePositives) == nKrns);
+		verify_test(kfs2.m_FalsePositives - kfs.m_FalsePositives < nKrns / 20);
+
+		for (uint32_t i = 0; i < nKrns; i++)
+		{
+			ECC::Hash::Value hv;
+			ECC::Hash::Processor() << i >> hv;
+			db.DeleteKernel(hv, 10);
+		}
 
 		tr.Commit();
+
+		{
+			NodeDB::Transaction tr2(db);
+			db.InsertKernel(bBodyP, 3);
+			verify_test(db.FindKernel(bBodyP) == 3);
+		} // rolled back
+
+		verify_test(db.FindKernel(bBodyP) == 0);
 	}
 
 #ifdef WIN32
@@ -460,6 +497,228 @@ namespace beam
 			NodeDB db;
 			db.Open(g_sz); // test to open already-existing DB
 		}
+
+		{
+			NodeDB::Profile prof; // WAL
+			NodeDB db;
+			db.Open(g_sz, &prof);
+
+			NodeDB dbRo;
+			dbRo.OpenReadOnly(g_sz);
+
+			const uint32_t nParamID = 1000; // unused by the node
+			const uint64_t nVal = 715;
+			NodeDB::Transaction t(db);
+			db.ParamSet(nParamID, &nVal, NULL);
+
+			verify_test(!dbRo.ParamIntGetDef(nParamID)); // not blocked, not committed yet
+			t.Commit();
+			verify_test(dbRo.ParamIntGetDef(nParamID) == nVal);
+
+			{
+				NodeDB::Snapshot snap(dbRo);
+
+				const uint64_t nVal2 = nVal + 1;
+				t.Start(db);
+				db.ParamSet(nParamID, &nVal2, NULL);
+				t.Commit();
+
+				verify_test(dbRo.ParamIntGetDef(nParamID) == nVal); // still the snapshot
+			}
+			verify_test(dbRo.ParamIntGetDef(nParamID) == nVal + 1);
+
+			bool bThrown = false;
+			try {
+				dbRo.ParamSet(nParamID + 1, &nVal, NULL);
+			} catch (const std::exception&) {
+				bThrown = true;
+			}
+			verify_test(bThrown);
+		}
+	}
+
+	void TestBlockStore(const char* sz)
+	{
+		const uint32_t nSegmentSize = 100;
+		const uint32_t nSegments = 4;
+
+		std::string pSeg[nSegments];
+		for (uint32_t i = 0; i < nSegments; i++)
+		{
+			char szSuffix[0x10];
+			snprintf(szSuffix, _countof(szSuffix), ".blk%06u", i);
+			pSeg[i] = std::string(sz) + szSuffix;
+			DeleteFile(pSeg[i].c_str());
+		}
+
+		auto IsPresent = [&pSeg](uint32_t iSegment)
+		{
+			std::FStream f;
+			return f.Open(pSeg[iSegment].c_str(), true);
+		};
+
+		const uint32_t hMax = 4;
+		uint64_t pRows[hMax];
+
+		uint8_t pBody[60];
+		auto VerifyBlock = [&pBody](NodeDB& db, uint64_t rowid, uint8_t nTag)
+		{
+			memset(pBody, nTag, sizeof(pBody));
+
+			ByteBuffer bbP, bbE;
+			db.GetStateBlock(rowid, &bbP, &bbE, NULL);
+			verify_test((bbP.size() == 60) && !memcmp(&bbP.front(), pBody, 60));
+			verify_test((bbE.size() == 30) && !memcmp(&bbE.front(), pBody, 30));
+
+			io::SharedBuffer bufP, bufE;
+			db.GetStateBlock(rowid, &bufP, &bufE);
+			verify_test((bufP.size == 60) && !memcmp(bufP.data, pBody, 60));
+			verify_test((bufE.size == 30) && !memcmp(bufE.data, pBody, 30));
+		};
+
+		{
+			NodeDB::Profile prof; // WAL, for the concurrent reader
+			prof.m_Synchronous = 2; // FULL, the commits are durable, the released segments are deleted immediately
+			NodeDB db;
+			db.Open(sz, &prof);
+			db.set_BlockSegmentSize(nSegmentSize);
+
+			NodeDB::Transaction tr(db);
+
+			Block::SystemState::Full s;
+			memset0(&s, sizeof(s));
+
+			for (uint32_t h = 0; h < hMax; h++)
+			{
+				s.m_Height = h + Rules::HeightGenesis;
+				s.m_ChainWork = h;
+				pRows[h] = db.InsertState(s);
+
+				// 90 bytes per block, the segment is switched once the size limit is reached: 0:[0, 0, 1P], 1:[1E, 2, 2], 2:[3, 3]
+				memset(pBody, static_cast<uint8_t>(h + 1), sizeof(pBody));
+				db.SetStateBlock(pRows[h], Blob(pBody, 60), Blob(pBody, 30));
+			}
+
+			tr.Commit();
+
+			verify_test(IsPresent(0) && IsPresent(1) && IsPresent(2) && !IsPresent(3));
+			for (uint32_t h = 0; h < hMax; h++)
+				VerifyBlock(db, pRows[h], static_cast<uint8_t>(h + 1));
+
+			// segment 0 becomes unused, but the transaction is rolled back
+			tr.Start(db);
+			db.DelStateBlockAll(pRows[0]);
+			db.DelStateBlockAll(pRows[1]);
+			verify_test(IsPresent(0)); // not before commit
+			tr.Rollback();
+
+			verify_test(IsPresent(0));
+			VerifyBlock(db, pRows[0], 1);
+			VerifyBlock(db, pRows[1], 2);
+
+			NodeDB dbRo;
+			dbRo.OpenReadOnly(sz);
+			{
+				NodeDB::Snapshot snap(dbRo);
+				VerifyBlock(dbRo, pRows[2], 3);
+
+				// now commit
+				tr.Start(db);
+				db.DelStateBlockAll(pRows[0]);
+				db.DelStateBlockAll(pRows[1]);
+				verify_test(IsPresent(0));
+				tr.Commit();
+
+				verify_test(!IsPresent(0) && IsPresent(1) && IsPresent(2));
+				VerifyBlock(db, pRows[2], 3);
+
+				// the reader's snapshot still references the deleted segment
+				bool bThrown = false;
+				try {
+					ByteBuffer bb;
+					dbRo.GetStateBlock(pRows[0], &bb, NULL, NULL);
+				} catch (const BlockStore::SegmentMissing&) {
+					bThrown = true;
+				}
+				verify_test(bThrown);
+			}
+
+			{
+				NodeDB::Snapshot snap(dbRo);
+
+				ByteBuffer bb;
+				dbRo.GetStateBlock(pRows[0], &bb, NULL, NULL);
+				verify_test(bb.empty());
+				VerifyBlock(dbRo, pRows[2], 3);
+			}
+		}
+
+		{
+			// reopen, the last segment is resumed
+			NodeDB db;
+			db.Open(sz);
+			db.set_BlockSegmentSize(nSegmentSize);
+
+			VerifyBlock(db, pRows[2], 3);
+			VerifyBlock(db, pRows[3], 4);
+
+			NodeDB::Transaction tr(db);
+			memset(pBody, 5, sizeof(pBody));
+			db.SetStateBlock(pRows[0], Blob(pBody, 60), Blob(pBody, 30)); // 2:[3, 3, 0P], 3:[0E]
+			tr.Commit();
+
+			verify_test(!IsPresent(0) && IsPresent(3));
+			VerifyBlock(db, pRows[0], 5);
+			VerifyBlock(db, pRows[3], 4);
+
+			// release the remaining blocks of segment 1 outside of a transaction, it's deleted immediately
+			db.DelStateBlockAll(pRows[2]);
+			verify_test(!IsPresent(1) && IsPresent(2));
+		}
+
+		{
+			// WAL with synchronous=NORMAL. The released segment is deleted only once the commit is checkpointed, the reader with an older snapshot prevents this
+			NodeDB::Profile prof;
+			NodeDB db;
+			db.Open(sz, &prof);
+			db.set_BlockSegmentSize(nSegmentSize);
+
+			NodeDB dbRo;
+			dbRo.OpenReadOnly(sz);
+
+			NodeDB::Transaction tr;
+			{
+				NodeDB::Snapshot snap(dbRo);
+				VerifyBlock(dbRo, pRows[3], 4);
+
+				tr.Start(db);
+				db.DelStateBlockAll(pRows[0]);
+				db.DelStateBlockAll(pRows[3]);
+				tr.Commit();
+
+				verify_test(IsPresent(2));
+			}
+
+			tr.Start(db);
+			tr.Commit();
+			verify_test(!IsPresent(2) && IsPresent(3));
+		}
+
+		{
+			// the segment released, but not deleted before the shutdown, is deleted on open
+			std::FStream f;
+			f.Open(pSeg[1].c_str(), false, true);
+			f.write("x", 1);
+			f.Close();
+
+			NodeDB db;
+			db.Open(sz);
+			verify_test(!IsPresent(1) && IsPresent(3));
+		}
+
+		DeleteFile(sz);
+		for (uint32_t i = 0; i < nSegments; i++)
+			DeleteFile(pSeg[i].c_str());
 	}
 
 	struct MiniWallet
@@ -661,6 +920,23 @@ namespace beam
 				np.m_TxPool.AddValidTx(std::move(pTx), ctx, key);
 			}
 
+			if (!(h % 8))
+			{
+				// incremental template: the 2nd generation only re-applies the selected txs
+				NodeProcessor::BlockTemplate bt;
+				NodeProcessor::BlockContext bc1(np.m_TxPool, *np.m_Wallet.m_pKdf);
+				bc1.m_pTemplate = &bt;
+				verify_test(np.GenerateNewBlock(bc1));
+				verify_test(!bt.HasUntried(np.m_TxPool));
+
+				NodeProcessor::BlockContext bc2(np.m_TxPool, *np.m_Wallet.m_pKdf);
+				bc2.m_pTemplate = &bt;
+				verify_test(np.GenerateNewBlock(bc2));
+				verify_test(bc2.m_Fees == bc1.m_Fees);
+				verify_test(bc2.m_Block.m_vInputs.size() == bc1.m_Block.m_vInputs.size());
+				verify_test(bc2.m_Block.m_vKernels.size() == bc1.m_Block.m_vKernels.size());
+			}
+
 			NodeProcessor::BlockContext bc(np.m_TxPool, *np.m_Wallet.m_pKdf);
 			verify_test(np.GenerateNewBlock(bc));
 
@@ -699,6 +975,17 @@ namespace beam
 					rw.ROpen();
 					return true;
 				}
+
+				uint32_t m_ProgressDone = 0;
+				uint32_t m_ProgressTotal = 0;
+
+				virtual void OnMacroblockProgress(uint32_t nDone, uint32_t nTotal) override
+				{
+					verify_test(nDone > m_ProgressDone);
+					verify_test(nDone <= nTotal);
+					m_ProgressDone = nDone;
+					m_ProgressTotal = nTotal;
+				}
 			};
 
 			MyNodeProcessorX np2;
@@ -713,11 +1000,15 @@ namespace beam
 			verify_test(np2.ImportMacroBlock(rwData));
 			rwData.Close();
 
+			verify_test(np2.m_ProgressTotal && (np2.m_ProgressDone == np2.m_ProgressTotal));
+			np2.m_ProgressDone = 0;
+
 			rwData.m_hvContentTag.Inc();
 			rwData.WCreate();
 			np.ExportMacroBlock(rwData, HeightRange(hMid + 1, Rules::HeightGenesis + blockChain.size() - 1)); // second half
 			rwData.Close();
 
+			rwData.m_bMapped = false; // the rest is imported via the regular file streams
 			rwData.ROpen();
 			verify_test(np2.ImportMacroBlock(rwData));
 			rwData.Close();
@@ -761,8 +1052,48 @@ namespace beam
 		virtual void OnNewState() override {}
 		virtual void AdjustFossilEnd(Height& h) override { h = 0; } // don't fossile anything, since we're not creating macroblocks
 
+		virtual bool IsValidPoW(const Block::SystemState::Full& s) override
+		{
+			return (m_PoWInvalid.end() == m_PoWInvalid.find(s.m_Height)) && NodeProcessor::IsValidPoW(s);
+		}
+
+		std::set<Height> m_PoWInvalid;
 	};
 
+	void TestHdrsBatch(NodeProcessor& np, std::vector<Block::SystemState::Full>& vStates, std::set<Height>& setPoWInvalid)
+	{
+		PeerID peer;
+		ZeroObject(peer);
+
+		uint32_t nStates = static_cast<uint32_t>(vStates.size());
+		verify_test(nStates > 4);
+
+		// the PoW of 2 headers is invalid, the lowest must be reported, and nothing above it accepted
+		uint32_t iBad = nStates / 3;
+		setPoWInvalid.insert(vStates[iBad].m_Height);
+		setPoWInvalid.insert(vStates[nStates - 2].m_Height);
+
+		verify_test(np.VerifyPoW(&vStates.front(), nStates) == iBad);
+		verify_test(np.VerifyPoW(&vStates.front(), iBad) == iBad);
+
+		uint32_t nAccepted = 0;
+		verify_test(np.OnStates(&vStates.front(), nStates, peer, nAccepted) == iBad);
+		verify_test(nAccepted == iBad);
+
+		// insane header, valid PoW
+		setPoWInvalid.clear();
+		Block::SystemState::Full sBad = vStates[iBad];
+		vStates[iBad].m_Height = 0;
+
+		verify_test(np.VerifyPoW(&vStates.front(), nStates) == nStates);
+		verify_test(np.OnStates(&vStates.front(), nStates, peer, nAccepted) == iBad);
+		verify_test(!nAccepted); // the ones below were already accepted
+
+		vStates[iBad] = sBad;
+		verify_test(np.OnStates(&vStates.front(), nStates, peer, nAccepted) == nStates);
+		verify_test(nAccepted == nStates - iBad);
+	}
+
 
 	void TestNodeProcessor2(std::vector<BlockPlus::Ptr>& blockChain)
 	{
@@ -812,6 +1143,22 @@ namespace beam
 				np.OnState(blockChain[i]->m_Hdr, peer);
 		}
 
+		{
+			// batch acceptance of the headers, on a separate DB
+			DeleteFile(g_sz2);
+
+			MyNodeProcessor2 np;
+			np.m_Horizon = horz;
+			np.Initialize(g_sz2);
+
+			std::vector<Block::SystemState::Full> vStates;
+			for (size_t i = 0; i < blockChain.size(); i++)
+				vStates.push_back(blockChain[i]->m_Hdr);
+
+			TestHdrsBatch(np, vStates, np.m_PoWInvalid);
+		}
+		DeleteFile(g_sz2);
+
 		{
 			MyNodeProcessor2 np;
 			np.m_Horizon = horz;
@@ -844,6 +1191,30 @@ namespace beam
 			}
 		}
 
+		{
+			// the UTXO snapshot saved on shutdown must give the same result as the full replay
+			Merkle::Hash hv0, hv1;
+			{
+				MyNodeProcessor2 np;
+				np.m_Horizon = horz;
+				np.Initialize(g_sz);
+				np.get_Utxos().get_Hash(hv0);
+
+				// no blocks were replayed
+				verify_test(np.m_Cursor.m_ID.m_Height > Rules::HeightGenesis);
+				verify_test(np.get_UtxoSnapshot() == np.m_Cursor.m_ID.m_Height);
+			}
+			{
+				MyNodeProcessor2 np;
+				np.m_Horizon = horz;
+				np.m_UtxoSnapshotPeriod = 0; // full replay
+				np.Initialize(g_sz);
+				np.get_Utxos().get_Hash(hv1);
+				verify_test(np.get_UtxoSnapshot() == Rules::HeightGenesis - 1);
+			}
+			verify_test(hv0 == hv1);
+		}
+
 		{
 			MyNodeProcessor2 np;
 			np.m_Horizon = horz;
@@ -852,6 +1223,26 @@ namespace beam
 
 	}
 
+	void TestNodeHdrsBatch(std::vector<BlockPlus::Ptr>& blockChain)
+	{
+		// same, the PoW is verified on the verification threads
+		io::Reactor::Ptr pReactor(io::Reactor::create());
+		io::Reactor::Scope scope(*pReactor);
+
+		Node node;
+		node.m_Cfg.m_sPathLocal = g_sz;
+		node.m_Cfg.m_VerificationThreads = 4;
+		ECC::SetRandom(node);
+
+		node.Initialize();
+
+		std::vector<Block::SystemState::Full> vStates;
+		for (size_t i = 0; i < blockChain.size(); i++)
+			vStates.push_back(blockChain[i]->m_Hdr);
+
+		TestHdrsBatch(node.get_Processor(), vStates, node.m_Cfg.m_TestMode.m_PoWInvalid);
+	}
+
 	const uint16_t g_Port = 25003; // don't use the default port to prevent collisions with running nodes, beacons and etc.
 
 	void TestNodeConversation()
@@ -976,6 +1367,55 @@ namespace beam
 
 
 
+	void TestRecoveryQueued()
+	{
+		// the recovery requested while the (next) block is being verified must wait for it and run on the verification threads, without affecting the verification result
+		Node node;
+		node.m_Cfg.m_VerificationThreads = 2;
+		ECC::SetRandom(node);
+
+		const uint32_t nOuts = 64; // verification takes long enough
+		Block::Body body;
+
+		for (uint32_t i = 0; i < nOuts; i++)
+		{
+			Key::IDV kidv;
+			ZeroObject(kidv);
+			kidv.m_Value = 100 + i;
+			kidv.m_Idx = i;
+
+			ECC::Scalar::Native k;
+			Output::Ptr pOut(new Output);
+			pOut->Create(k, *node.m_Keys.m_pMiner, kidv, true);
+			body.m_vOutputs.push_back(std::move(pOut));
+		}
+		body.m_Offset = Zero;
+
+		NodeProcessor& proc = node.get_Processor();
+
+		TxBase::IReader::Ptr pR;
+		body.get_Reader().Clone(pR);
+
+		HeightRange hr(Rules::HeightGenesis, Rules::HeightGenesis);
+		proc.VerifyBlockBegin(body, *pR, hr);
+
+		std::vector<const Output*> vPtrs;
+		for (uint32_t i = 0; i < nOuts; i++)
+			vPtrs.push_back(body.m_vOutputs[i].get());
+
+		std::vector<NodeProcessor::RecoveredOutput> vRes(nOuts);
+		proc.RecoverOutputs(&vRes.front(), &vPtrs.front(), nOuts);
+
+		for (uint32_t i = 0; i < nOuts; i++)
+			verify_test(vRes[i].m_Recovered && (vRes[i].m_Kidv.m_Value == 100 + i));
+
+		verify_test(!proc.VerifyBlockEnd(body, *pR, hr)); // the outputs are valid, but the block isn't balanced
+
+		Node::RecoveryStats rcStats;
+		node.get_RecoveryStats(rcStats);
+		verify_test((rcStats.m_Parallel == 1) && (rcStats.m_Queued == 1));
+	}
+
 	void TestNodeClientProto()
 	{
 		// Testing configuration: Node <-> Client. Node is a miner
@@ -992,6 +1432,13 @@ namespace beam
 
 		ECC::SetRandom(node);
 
+		{
+			// unrelated viewer key ahead of the miner's. Outputs must still be attributed to the miner key
+			Key::IKdf::Ptr pKdf;
+			ECC::SetRandom(pKdf);
+			node.m_Keys.m_vMonitored.insert(node.m_Keys.m_vMonitored.begin(), Node::Keys::Viewer(7, pKdf));
+		}
+
 		node.m_Cfg.m_Horizon.m_Branching = 6;
 		node.m_Cfg.m_Horizon.m_Schwarzschild = 8;
 		node.m_Cfg.m_VerificationThreads = -1;
@@ -1017,6 +1464,7 @@ namespace beam
 			uint32_t m_nChainWorkProofsPending = 0;
 			uint32_t m_nBbsMsgsPending = 0;
 			uint32_t m_nRecoveryPending = 0;
+			uint32_t m_nBodiesPending = 0;
 
 
 			MyClient(const Key::IKdf::Ptr& pKdf)
@@ -1082,7 +1530,8 @@ namespace beam
 					m_queProofsExpected.empty() &&
 					m_queProofsKrnExpected.empty() &&
 					m_queProofsStateExpected.empty() &&
-					!m_nChainWorkProofsPending;
+					!m_nChainWorkProofsPending &&
+					!m_nBodiesPending;
 			}
 
 			bool IsAllBbsReceived() const
@@ -1187,6 +1636,15 @@ namespace beam
 					m_nChainWorkProofsPending++;
 				}
 
+				for (int i = 0; i < 2; i++)
+				{
+					// the same block twice, the latter should be served from the cache
+					proto::GetBody msgOut2;
+					msg.m_Description.get_ID(msgOut2.m_ID);
+					Send(msgOut2);
+					m_nBodiesPending++;
+				}
+
 				proto::NewTransaction msgTx;
 				while (true)
 				{
@@ -1315,12 +1773,23 @@ namespace beam
 				m_nChainWorkProofsPending--;
 			}
 
+			virtual void OnMsg(proto::Body&& msg) override
+			{
+				verify_test(m_nBodiesPending);
+				m_nBodiesPending--;
+
+				verify_test(!msg.m_Perishable.empty());
+			}
+
 			virtual void OnMsg(proto::UtxoEvents&& msg) override
 			{
 				verify_test(m_nRecoveryPending);
 				m_nRecoveryPending--;
 
 				verify_test(!msg.m_Events.empty());
+
+				for (size_t i = 0; i < msg.m_Events.size(); i++)
+					verify_test(!msg.m_Events[i].m_Kidvc.m_iChild);
 			}
 
 			virtual void OnMsg(proto::GetBlockFinalization&& msg) override
@@ -1429,8 +1898,16 @@ namespace beam
 
 		node2.m_Cfg.m_Sync.m_Timeout_ms = 0; // sync immediately after seeing 1st peer
 		node2.m_Cfg.m_Dandelion = node.m_Cfg.m_Dandelion;
+		node2.m_Cfg.m_VerificationThreads = 2; // fluff txs validated asynchronously
 
 		ECC::SetRandom(node2);
+
+		{
+			// additional viewer key, so that each block has enough (output, key) pairs for the parallel recovery
+			Key::IKdf::Ptr pKdf;
+			ECC::SetRandom(pKdf);
+			node2.m_Keys.m_vMonitored.push_back(Node::Keys::Viewer(7, pKdf));
+		}
 		node2.Initialize();
 
 		pReactor->run();
@@ -1450,6 +1927,25 @@ namespace beam
 		urec.Proceed();
 
 		verify_test(!urec.m_Map.empty());
+
+		const Node::ServeCacheStats& csStats = node.get_ServeCacheStats();
+		verify_test(csStats.m_Hits && csStats.m_Misses);
+		verify_test(csStats.m_Bytes <= node.m_Cfg.m_ServeCacheSize);
+
+		std::vector<Node::VerifierStats> vStats;
+		node2.get_VerifierStats(vStats);
+		verify_test(vStats.size() == static_cast<size_t>(node2.m_Cfg.m_VerificationThreads));
+		for (size_t i = 0; i < vStats.size(); i++)
+			verify_test(vStats[i].m_Elements); // all the verifiers took part
+
+		Node::RecoveryStats rcStats;
+		node2.get_RecoveryStats(rcStats);
+		verify_test(rcStats.m_Parallel); // the outputs were recovered on the verification threads during the sync
+
+		ECC::PointCache::Stats pcStats;
+		node2.get_PointCacheStats(pcStats);
+		verify_test(pcStats.m_Inserts && pcStats.m_Hits); // spent outputs were validated by this node
+		verify_test(pcStats.m_Hits <= pcStats.m_Lookups);
 	}
 
 
@@ -1726,6 +2222,11 @@ int main()
 	beam::TestNodeDB();
 	beam::DeleteFile(beam::g_sz);
 
+	printf("BlockStore test...\n");
+	fflush(stdout);
+
+	beam::TestBlockStore(beam::g_sz);
+
 	{
 		printf("NodeProcessor test1...\n");
 		fflush(stdout);
@@ -1741,6 +2242,12 @@ int main()
 
 		beam::TestNodeProcessor2(blockChain);
 		beam::DeleteFile(beam::g_sz);
+
+		printf("Node header batch test...\n");
+		fflush(stdout);
+
+		beam::TestNodeHdrsBatch(blockChain);
+		beam::DeleteFile(beam::g_sz);
 	}
 
 	printf("NodeX2 concurrent test...\n");
@@ -1757,6 +2264,11 @@ int main()
 	beam::DeleteFile(beam::g_sz);
 	beam::DeleteFile(beam::g_sz2);
 
+	printf("Output recovery during the block verification...\n");
+	fflush(stdout);
+
+	beam::TestRecoveryQueued();
+
 	printf("Node <---> FlyClient test...\n");
 	fflush(stdout);
 
@@ -41,6 +41,15 @@ size_t MsgSerializeOstream::write(const void *ptr, size_t size) {
     return size;
 }
 
+void MsgSerializeOstream::write_external(const io::SharedBuffer& buf) {
+    assert(_currentHeaderPtr != 0);
+    if (!buf.size) return;
+    _writer.finalize(); // flush what's written so far, the following data goes after the external fragment
+    _currentMsgSize += buf.size;
+    _fragments.push_back(buf);
+    _hasExternal = true;
+}
+
 void MsgSerializeOstream::finalize(SerializedMsg& fragments, size_t externalTailSize) {
     assert(_currentHeaderPtr != 0);
     _writer.finalize();
@@ -56,6 +65,7 @@ void MsgSerializeOstream::clear() {
     _fragments.clear();
     _currentMsgSize = 0;
     _currentHeaderPtr = 0;
+    _hasExternal = false;
 }
 
 } //namespace
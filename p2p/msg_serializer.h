@@ -32,6 +32,12 @@ public:
     /// Called by yas serializeron new data
     size_t write(const void *ptr, size_t size);
 
+    /// Appends the buffer as a separate fragment, no copying. The buffer must stay unmodified until sent
+    void write_external(const io::SharedBuffer& buf);
+
+    /// Returns true if the current message references external fragments (they're read-only)
+    bool has_external() const { return _hasExternal; }
+
     /// Called by msg serializer on finalizing msg
     /// If externalTailSize > 0 then serialized msg must be followed by raw buffer of thet size
     void finalize(SerializedMsg& fragments, size_t externalTailSize=0);
@@ -52,6 +58,9 @@ private:
     /// Pointer to msg header which is filled on finalize() when size is known
     void* _currentHeaderPtr=0;
 
+    /// External fragments were appended to the current message
+    bool _hasExternal=false;
+
     /// Current header
     MsgHeader _currentHeader;
 };
@@ -75,6 +84,23 @@ public:
         return *this;
     }
 
+    /// Serializes the buffer the same way as a byte vector, yet the data is referenced rather than copied
+    MsgSerializer& write_external(const io::SharedBuffer& buf) {
+        _oa.write_seq_size(buf.size);
+        _os.write_external(buf);
+        return *this;
+    }
+
+    /// Appends already-serialized data as is, referenced rather than copied
+    MsgSerializer& append_external(const io::SharedBuffer& buf) {
+        _os.write_external(buf);
+        return *this;
+    }
+
+    bool has_external() const {
+        return _os.has_external();
+    }
+
     /// Finalizes current message serialization. Returns serialized data in fragments
     /// If externalTailSize > 0 then serialized msg must be followed by raw buffer of thet size
     void finalize(SerializedMsg& fragments, size_t externalTailSize=0) {
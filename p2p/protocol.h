@@ -107,6 +107,12 @@ public:
 		return _ser;
 	}
 
+	/// Begins the message, its members are to be serialized by the caller
+	MsgSerializer& serializeBegin(MsgType type) {
+		_ser.new_message(type);
+		return _ser;
+	}
+
 	/// If externalTailSize > 0 then serialized msg must be followed by raw buffer of thet size
     template <typename MsgObject> io::SharedBuffer serialize(
         MsgType type, const MsgObject& obj, bool makeUnique, size_t externalTailSize=0
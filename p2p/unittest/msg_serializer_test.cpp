@@ -17,6 +17,7 @@
 #include "p2p/protocol.h"
 #include "utility/helpers.h"
 #include <iostream>
+#include <algorithm>
 #include <assert.h>
 
 using namespace beam;
@@ -183,8 +184,50 @@ void msg_serializer_test_2() {
     assert(msg == handler.receivedObj);
 }
 
+struct ObjectWithBlob {
+    int i=0;
+    std::vector<uint8_t> blob;
+    size_t x=0;
+
+    SERIALIZE(i,blob,x);
+};
+
+void msg_serializer_external_test() {
+    MsgType type = 77;
+
+    MsgHandler handler;
+    Protocol protocol(0xAA, 0xBB, 0xCC, 256, handler, 50);
+
+    ObjectWithBlob msg;
+    msg.i = 5;
+    msg.x = 0x12345;
+    for (int i=0; i<300; ++i) msg.blob.push_back(uint8_t(i));
+
+    io::SharedBuffer expected = protocol.serialize(type, msg, true);
+
+    // the blob is referenced, not copied, the resulting message must be the same
+    io::SharedBuffer blob(msg.blob.data(), msg.blob.size());
+
+    MsgSerializer& ser = protocol.serializeBegin(type);
+    ser & msg.i;
+    ser.write_external(blob);
+    ser & msg.x;
+    assert(ser.has_external());
+
+    std::vector<io::SharedBuffer> fragments;
+    ser.finalize(fragments);
+    assert(!ser.has_external());
+
+    assert(std::any_of(fragments.begin(), fragments.end(), [&](const io::SharedBuffer& f) { return f.data == blob.data; }));
+
+    io::SharedBuffer actual = io::normalize(fragments);
+    assert(actual.size == expected.size);
+    assert(!memcmp(actual.data, expected.data, actual.size));
+}
+
 int main() {
     fragment_writer_test();
     msg_serializer_test_1();
     msg_serializer_test_2();
+    msg_serializer_external_test();
 }
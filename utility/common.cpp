@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "common.h"
+#include "io/buffer.h"
 #include <exception>
 
 #ifndef WIN32
@@ -116,11 +117,16 @@ namespace std
 
 	FStream::FStream()
 		:m_Remaining(0)
+		,m_pMap(nullptr)
+		,m_nMap(0)
 	{
 	}
 
 	bool FStream::Open(const char* sz, bool bRead, bool bStrict /* = false */, bool bAppend /* = false */)
 	{
+		if (IsMapped())
+			Close();
+
 		m_Remaining = 0;
 
 		int mode = ios_base::binary;
@@ -151,8 +157,49 @@ namespace std
 		return true;
 	}
 
+	bool FStream::OpenMapped(const char* sz, bool bStrict /* = false */)
+	{
+		Close();
+
+		beam::io::SharedBuffer buf;
+		try {
+			buf = beam::io::map_file_read_only(sz);
+		}
+		catch (const std::exception&) {
+			if (bStrict)
+				throw;
+			return false;
+		}
+
+		m_pMapGuard = buf.guard;
+		m_pMap = buf.data;
+		m_nMap = buf.size;
+		m_Remaining = m_nMap;
+
+		return true;
+	}
+
+	void FStream::OpenMapped(const FStream& s)
+	{
+		assert(s.IsMapped());
+		Close();
+
+		m_pMapGuard = s.m_pMapGuard;
+		m_pMap = s.m_pMap;
+		m_nMap = s.m_nMap;
+		m_Remaining = m_nMap;
+	}
+
 	void FStream::Close()
 	{
+		if (IsMapped())
+		{
+			m_pMapGuard.reset();
+			m_pMap = nullptr;
+			m_nMap = 0;
+			m_Remaining = 0;
+		}
+
 		if (m_F.is_open())
 		{
 			m_F.close();
@@ -162,12 +209,24 @@ namespace std
 
 	void FStream::Restart()
 	{
+		if (IsMapped())
+		{
+			m_Remaining = m_nMap;
+			return;
+		}
+
 		m_Remaining += m_F.tellg();
 		m_F.seekg(0);
 	}
 
 	void FStream::Seek(uint64_t n)
 	{
+		if (IsMapped())
+		{
+			m_Remaining = m_nMap - std::min(n, m_nMap);
+			return;
+		}
+
 		m_Remaining += m_F.tellg();
 		m_F.seekg(n);
 		m_Remaining -= m_F.tellg();
@@ -180,6 +239,16 @@ namespace std
 
 	size_t FStream::read(void* pPtr, size_t nSize)
 	{
+		if (IsMapped())
+		{
+			if (nSize > m_Remaining)
+				throw runtime_error("underflow");
+
+			memcpy(pPtr, m_pMap + (m_nMap - m_Remaining), nSize);
+			m_Remaining -= nSize;
+			return nSize;
+		}
+
 		m_F.read((char*)pPtr, nSize);
 		size_t ret = m_F.gcount();
 		m_Remaining -= ret;
@@ -192,6 +261,9 @@ namespace std
 
 	size_t FStream::write(const void* pPtr, size_t nSize)
 	{
+		if (IsMapped())
+			NotImpl();
+
 		m_F.write((char*) pPtr, nSize);
 		TestNoError(m_F);
 
@@ -220,6 +292,9 @@ namespace std
 
 	void FStream::Flush()
 	{
+		if (IsMapped())
+			return;
+
 		m_F.flush();
 		TestNoError(m_F);
 	}
@@ -209,18 +209,26 @@ namespace std
 		std::fstream m_F;
 		uint64_t m_Remaining; // used in read-stream, to indicate the EOF before trying to deserialize something
 
+		// mapped read-only mode
+		std::shared_ptr<void> m_pMapGuard;
+		const uint8_t* m_pMap;
+		uint64_t m_nMap;
+
 		static void NotImpl();
 
 	public:
 		FStream();
 		bool Open(const char*, bool bRead, bool bStrict = false, bool bAppend = false); // strict - throw exc if error
-		bool IsOpen() const { return m_F.is_open(); }
+		bool OpenMapped(const char*, bool bStrict = false); // read-only, the file is memory-mapped, no syscalls on read
+		void OpenMapped(const FStream&); // share the mapping of another stream, starting from the beginning
+		bool IsMapped() const { return m_pMapGuard != nullptr; }
+		bool IsOpen() const { return IsMapped() || m_F.is_open(); }
 		void Close();
 		uint64_t get_Remaining() const { return m_Remaining; }
 
 		void Restart(); // for read-stream - jump to the beginning of the file
 		void Seek(uint64_t);
-		uint64_t Tell() { return m_F.tellg(); }
+		uint64_t Tell() { return IsMapped() ? (m_nMap - m_Remaining) : (uint64_t) m_F.tellg(); }
 
 		// read/write always return the size requested. Exception is thrown if underflow or error
 		size_t read(void* pPtr, size_t nSize);
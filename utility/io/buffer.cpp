@@ -57,7 +57,8 @@ struct HeapAllocatedMemory : AllocatedMemory {
 
 struct ReadOnlyMappedFileWin32 : AllocatedMemory {
     explicit ReadOnlyMappedFileWin32(const char* fileName) {
-        fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_ALWAYS, NULL, NULL);
+        // the file may be still appended by another handle (block store), and deleted while mapped
+        fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, NULL);
         if (fileHandle == INVALID_HANDLE_VALUE)
             throw std::runtime_error(std::string("ReadOnlyMappedFile: cannot open ") + fileName);
         DWORD fileSizeHigh = 0;
@@ -65,7 +66,8 @@ struct ReadOnlyMappedFileWin32 : AllocatedMemory {
         size += uint64_t(fileSizeHigh) << 32;
         if (size > 0) {
             mappingHandle = CreateFileMapping(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
-            if (mappingHandle == INVALID_HANDLE_VALUE) {
+            if (!mappingHandle) {
+                mappingHandle = INVALID_HANDLE_VALUE;
                 CloseHandle(fileHandle);
                 fileHandle = INVALID_HANDLE_VALUE;
                 throw std::runtime_error(std::string("ReadOnlyMappedFile: cannot open mapping ") + fileName);
@@ -73,6 +75,8 @@ struct ReadOnlyMappedFileWin32 : AllocatedMemory {
             data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, size);
             if (!data) {
                 CloseHandle(mappingHandle);
+                mappingHandle = INVALID_HANDLE_VALUE;
+                CloseHandle(fileHandle);
                 fileHandle = INVALID_HANDLE_VALUE;
                 throw std::runtime_error(std::string("ReadOnlyMappedFile: cannot view mapping ") + fileName);
             }
@@ -118,6 +122,9 @@ struct ReadOnlyMappedFile : AllocatedMemory {
                 throw std::runtime_error(std::string("ReadOnlyMappedFile: cannot mmap ") + fileName);
             }
         }
+        // the mapping stays valid without the descriptor, don't hold it (many mappings may be alive)
+        close(fd);
+        fd = -1;
     }
 
     ~ReadOnlyMappedFile() {
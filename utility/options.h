@@ -37,6 +37,7 @@ namespace beam
         extern const char* IMPORT;
         extern const char* MINING_THREADS;
         extern const char* VERIFICATION_THREADS;
+        extern const char* VERIFICATION_BATCH;
         extern const char* NODE_PEER;
         extern const char* PASS;
         extern const char* AMOUNT;